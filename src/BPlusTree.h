@@ -0,0 +1,921 @@
+#ifndef AISDI_MAPS_BPLUSTREE_H
+#define AISDI_MAPS_BPLUSTREE_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "MemoryUsage.h"
+#include "NodePool.h"
+
+namespace aisdi
+{
+
+// B+ tree: inner nodes keep only separator keys in one contiguous array, so a lookup touches
+// a few cache lines per level, and all elements live in leaves linked into a list for iteration.
+// Fanout is the maximal number of children of an inner node and of elements in a leaf,
+// zero picks one that fits inner node keys into four cache lines.
+// Elements shift within and between leaves on insertion and removal, so unlike the red-black tree's,
+// references and iterators to elements are invalidated by any insertion or removal.
+template <typename KeyType, typename ValueType, std::size_t Fanout = 0,
+          typename Allocator = PoolAllocator<std::pair<const KeyType, ValueType>>>
+class BPlusTree
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+
+private:
+    enum : size_type
+    {
+        keysInCacheLines = 4 * 64 / sizeof(key_type),
+        maxChildren = Fanout != 0 ? Fanout
+                    : keysInCacheLines < 8 ? 8 : keysInCacheLines > 64 ? 64 : keysInCacheLines,
+        maxKeys = maxChildren - 1,
+        minKeys = (maxChildren - 1) / 2,
+        leafCapacity = maxChildren,
+        minLeafCount = leafCapacity / 2
+    };
+    static_assert(maxChildren >= 4, "B+ tree fanout has to be at least 4.");
+
+    using Slot = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+    using KeySlot = typename std::aligned_storage<sizeof(key_type), alignof(key_type)>::type;
+
+    struct Node
+    {
+        size_type count; // elements in a leaf, keys in an inner node
+    };
+
+    struct Leaf : Node
+    {
+        Leaf * prev;
+        Leaf * next;
+        Slot slots[leafCapacity];
+    };
+
+    struct Inner : Node // keys[i] is the smallest key that may be found under children[i + 1]
+    {
+        KeySlot keys[maxKeys + 1];              // one spare key and child hold the overflow before a split
+        Node * children[maxChildren + 1];
+    };
+
+public:
+    struct Handle // leaf and index inside it, leaf is nullptr for the end
+    {
+        Leaf * leaf;
+        size_type index;
+
+        bool operator==(const Handle& other) const
+        {
+            return leaf == other.leaf && index == other.index;
+        }
+
+        bool operator!=(const Handle& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+private:
+    Node * root;        // nullptr for an empty tree
+    Leaf * firstLeaf;
+    Leaf * lastLeaf;
+    size_type height;   // levels of inner nodes above the leaves
+    size_type size;
+
+    using LeafAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Leaf>;
+    using InnerAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Inner>;
+    LeafAllocator leafAllocator;
+    InnerAllocator innerAllocator;
+
+    template <typename NodeType, typename NodeAllocator>
+    static NodeType * createNode(NodeAllocator& allocator) // value initialized, counts and links are zero
+    {
+        NodeType *node = std::allocator_traits<NodeAllocator>::allocate(allocator, 1);
+        try
+        {
+            new (node) NodeType();
+        }
+        catch(...)
+        {
+            std::allocator_traits<NodeAllocator>::deallocate(allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    template <typename NodeType, typename NodeAllocator>
+    static void destroyNode(NodeAllocator& allocator, NodeType *node)
+    {
+        node->~NodeType();
+        std::allocator_traits<NodeAllocator>::deallocate(allocator, node, 1);
+    }
+
+    Leaf * createLeaf()
+    {
+        return createNode<Leaf>(leafAllocator);
+    }
+
+    Inner * createInner()
+    {
+        return createNode<Inner>(innerAllocator);
+    }
+
+    void destroyLeaf(Leaf *leaf) // elements have to be destroyed already
+    {
+        destroyNode(leafAllocator, leaf);
+    }
+
+    void destroyInner(Inner *inner) // its count keys are destroyed with it
+    {
+        for(size_type i = 0; i < inner->count; i++)
+            storedKey(inner->keys[i]).~key_type();
+        destroyNode(innerAllocator, inner);
+    }
+
+    Inner * reserveInners(size_type count) // linked through children[0], all or none of them
+    {
+        Inner *reserved = nullptr;
+        try
+        {
+            for(; count > 0; count--)
+            {
+                Inner *inner = createInner();
+                inner->children[0] = reserved;
+                reserved = inner;
+            }
+        }
+        catch(...)
+        {
+            releaseInners(reserved);
+            throw;
+        }
+        return reserved;
+    }
+
+    void releaseInners(Inner *reserved)
+    {
+        while(reserved != nullptr)
+        {
+            Inner *next = static_cast<Inner*>(reserved->children[0]);
+            destroyInner(reserved);
+            reserved = next;
+        }
+    }
+
+    static Inner * takeInner(Inner *&reserved)
+    {
+        Inner *inner = reserved;
+        reserved = static_cast<Inner*>(inner->children[0]);
+        inner->children[0] = nullptr;
+        return inner;
+    }
+
+    static value_type& element(const Leaf *leaf, size_type index)
+    {
+        return *reinterpret_cast<value_type*>(const_cast<Slot*>(leaf->slots + index));
+    }
+
+    static void moveElement(Leaf *from, size_type fromIndex, Leaf *to, size_type toIndex) // to slot has to be free
+    {
+        new (to->slots + toIndex) value_type(std::move(element(from, fromIndex)));
+        element(from, fromIndex).~value_type();
+    }
+
+    static key_type& storedKey(const KeySlot& slot)
+    {
+        return *reinterpret_cast<key_type*>(const_cast<KeySlot*>(&slot));
+    }
+
+    static void moveKey(KeySlot& from, KeySlot& to) // to slot has to be free, from slot is free afterwards
+    {
+        new (&to) key_type(std::move(storedKey(from)));
+        storedKey(from).~key_type();
+    }
+
+    template <typename LookupKey>
+    static size_type lowerBound(const Leaf *leaf, const LookupKey& key) // first element not less than key
+    {
+        size_type low = 0, high = leaf->count;
+        while(low < high)
+        {
+            size_type middle = (low + high) / 2;
+            if(element(leaf, middle).first < key)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    template <typename LookupKey>
+    static size_type childIndex(const Inner *inner, const LookupKey& key) // number of keys not greater than key
+    {
+        size_type low = 0, high = inner->count;
+        while(low < high)
+        {
+            size_type middle = (low + high) / 2;
+            if(key < storedKey(inner->keys[middle]))
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        return low;
+    }
+
+    template <typename LookupKey>
+    const Leaf * findLeaf(const LookupKey& key) const
+    {
+        const Node *node = root;
+        for(size_type level = height; level > 0; level--)
+        {
+            const Inner *inner = static_cast<const Inner*>(node);
+            node = inner->children[childIndex(inner, key)];
+        }
+        return static_cast<const Leaf*>(node);
+    }
+
+    void linkAfter(Leaf *leaf, Leaf *added)
+    {
+        added->prev = leaf;
+        added->next = leaf->next;
+        if(leaf->next != nullptr)
+            leaf->next->prev = added;
+        else
+            lastLeaf = added;
+        leaf->next = added;
+    }
+
+    void unlink(Leaf *leaf)
+    {
+        if(leaf->prev != nullptr)
+            leaf->prev->next = leaf->next;
+        else
+            firstLeaf = leaf->next;
+        if(leaf->next != nullptr)
+            leaf->next->prev = leaf->prev;
+        else
+            lastLeaf = leaf->prev;
+    }
+
+    // The nodes a split needs, splitInners inner ones, are all allocated before anything is changed.
+    template <typename Key, typename... Args>
+    Handle insertIntoLeaf(Leaf *leaf, Key&& key, Node *&right, KeySlot& separator, bool& inserted,
+                          size_type splitInners, Inner *&reserved, Args&&... args)
+    {
+        size_type index = lowerBound(leaf, key);
+        inserted = !(index < leaf->count && element(leaf, index).first == key);
+        if(!inserted)
+            return Handle{leaf, index};
+
+        Leaf *target = leaf;
+        if(leaf->count == leafCapacity) // full, upper half goes to a new leaf
+        {
+            Leaf *added = createLeaf();
+            try
+            {
+                reserved = reserveInners(splitInners);
+            }
+            catch(...)
+            {
+                destroyLeaf(added);
+                throw;
+            }
+            for(size_type i = leafCapacity / 2; i < leafCapacity; i++)
+                moveElement(leaf, i, added, i - leafCapacity / 2);
+            added->count = leafCapacity - leafCapacity / 2;
+            leaf->count = leafCapacity / 2;
+            linkAfter(leaf, added);
+            right = added;
+
+            if(index > leaf->count)
+            {
+                target = added;
+                index -= leaf->count;
+            }
+        }
+
+        for(size_type i = target->count; i > index; i--)
+            moveElement(target, i - 1, target, i);
+        try
+        {
+            new (target->slots + index) value_type(std::piecewise_construct,
+                                                   std::forward_as_tuple(std::forward<Key>(key)),
+                                                   std::forward_as_tuple(std::forward<Args>(args)...));
+            if(right != nullptr)
+                try
+                {
+                    new (&separator) key_type(element(static_cast<Leaf*>(right), 0).first);
+                }
+                catch(...)
+                {
+                    element(target, index).~value_type();
+                    throw;
+                }
+        }
+        catch(...) // the leaf is put back as it was, a split one is merged again
+        {
+            for(size_type i = index; i < target->count; i++)
+                moveElement(target, i + 1, target, i);
+            if(right != nullptr)
+            {
+                mergeLeaves(leaf, static_cast<Leaf*>(right));
+                right = nullptr;
+            }
+            throw;
+        }
+        target->count++;
+        size++;
+        return Handle{target, index};
+    }
+
+    // Inner holds one key too many, the new node comes from those reserved for the split.
+    static void splitInner(Inner *inner, Node *&right, KeySlot& separator, Inner *&reserved)
+    {
+        Inner *added = takeInner(reserved);
+        size_type middle = inner->count / 2;
+        moveKey(inner->keys[middle], separator);
+        for(size_type i = middle + 1; i < inner->count; i++)
+            moveKey(inner->keys[i], added->keys[i - middle - 1]);
+        for(size_type i = middle + 1; i <= inner->count; i++)
+            added->children[i - middle - 1] = inner->children[i];
+        added->count = inner->count - middle - 1;
+        inner->count = middle;
+        right = added;
+    }
+
+    // Inserts key into the subtree of node, a split of node is reported by setting right and constructing
+    // the separator in its slot. A split reaching node needs splitInners inner nodes above it, a new root
+    // included, the leaf reserves them together with those of full inner nodes on the way.
+    template <typename Key, typename... Args>
+    Handle insertInto(Node *node, size_type level, Key&& key, Node *&right, KeySlot& separator, bool& inserted,
+                      size_type splitInners, Inner *&reserved, Args&&... args)
+    {
+        right = nullptr;
+        if(level == 0)
+            return insertIntoLeaf(static_cast<Leaf*>(node), std::forward<Key>(key), right, separator, inserted,
+                                  splitInners, reserved, std::forward<Args>(args)...);
+
+        Inner *inner = static_cast<Inner*>(node);
+        size_type index = childIndex(inner, key);
+        Node *childRight;
+        KeySlot childSeparator;
+        Handle position = insertInto(inner->children[index], level - 1, std::forward<Key>(key), childRight,
+                                     childSeparator, inserted, inner->count == maxKeys ? splitInners + 1 : 0,
+                                     reserved, std::forward<Args>(args)...);
+        if(childRight == nullptr)
+            return position;
+
+        for(size_type i = inner->count; i > index; i--)
+        {
+            moveKey(inner->keys[i - 1], inner->keys[i]);
+            inner->children[i + 1] = inner->children[i];
+        }
+        moveKey(childSeparator, inner->keys[index]);
+        inner->children[index + 1] = childRight;
+        inner->count++;
+
+        if(inner->count > maxKeys)
+            splitInner(inner, right, separator, reserved);
+        return position;
+    }
+
+    static void removeChild(Inner *inner, size_type index) // drops keys[index] and children[index + 1]
+    {
+        storedKey(inner->keys[index]).~key_type();
+        for(size_type i = index + 1; i < inner->count; i++)
+        {
+            moveKey(inner->keys[i], inner->keys[i - 1]);
+            inner->children[i] = inner->children[i + 1];
+        }
+        inner->count--;
+    }
+
+    void mergeLeaves(Leaf *left, Leaf *right) // right is freed
+    {
+        for(size_type i = 0; i < right->count; i++)
+            moveElement(right, i, left, left->count + i);
+        left->count += right->count;
+        unlink(right);
+        destroyLeaf(right);
+    }
+
+    // Right is freed, separator is moved from and is left for removeChild to destroy.
+    void mergeInner(Inner *left, key_type& separator, Inner *right)
+    {
+        new (left->keys + left->count) key_type(std::move(separator));
+        for(size_type i = 0; i < right->count; i++)
+            moveKey(right->keys[i], left->keys[left->count + 1 + i]);
+        for(size_type i = 0; i <= right->count; i++)
+            left->children[left->count + 1 + i] = right->children[i];
+        left->count += right->count + 1;
+        right->count = 0;
+        destroyInner(right);
+    }
+
+    void rebalanceLeaf(Inner *parent, size_type index) // children[index] has too few elements
+    {
+        Leaf *child = static_cast<Leaf*>(parent->children[index]);
+        Leaf *left = index > 0 ? static_cast<Leaf*>(parent->children[index - 1]) : nullptr;
+        Leaf *right = index < parent->count ? static_cast<Leaf*>(parent->children[index + 1]) : nullptr;
+
+        if(left != nullptr && left->count > minLeafCount)           // borrow the last element of the left sibling
+        {
+            for(size_type i = child->count; i > 0; i--)
+                moveElement(child, i - 1, child, i);
+            moveElement(left, left->count - 1, child, 0);
+            left->count--;
+            child->count++;
+            storedKey(parent->keys[index - 1]) = element(child, 0).first;
+        }
+        else if(right != nullptr && right->count > minLeafCount)    // borrow the first element of the right sibling
+        {
+            moveElement(right, 0, child, child->count);
+            for(size_type i = 1; i < right->count; i++)
+                moveElement(right, i, right, i - 1);
+            right->count--;
+            child->count++;
+            storedKey(parent->keys[index]) = element(right, 0).first;
+        }
+        else if(left != nullptr)
+        {
+            mergeLeaves(left, child);
+            removeChild(parent, index - 1);
+        }
+        else
+        {
+            mergeLeaves(child, right);
+            removeChild(parent, index);
+        }
+    }
+
+    void rebalanceInner(Inner *parent, size_type index) // children[index] has too few keys
+    {
+        Inner *child = static_cast<Inner*>(parent->children[index]);
+        Inner *left = index > 0 ? static_cast<Inner*>(parent->children[index - 1]) : nullptr;
+        Inner *right = index < parent->count ? static_cast<Inner*>(parent->children[index + 1]) : nullptr;
+
+        if(left != nullptr && left->count > minKeys)                // rotate through the parent from the left
+        {
+            for(size_type i = child->count; i > 0; i--)
+                moveKey(child->keys[i - 1], child->keys[i]);
+            for(size_type i = child->count + 1; i > 0; i--)
+                child->children[i] = child->children[i - 1];
+            moveKey(parent->keys[index - 1], child->keys[0]);
+            child->children[0] = left->children[left->count];
+            child->count++;
+            moveKey(left->keys[left->count - 1], parent->keys[index - 1]);
+            left->count--;
+        }
+        else if(right != nullptr && right->count > minKeys)         // rotate through the parent from the right
+        {
+            moveKey(parent->keys[index], child->keys[child->count]);
+            child->children[child->count + 1] = right->children[0];
+            child->count++;
+            moveKey(right->keys[0], parent->keys[index]);
+            for(size_type i = 1; i < right->count; i++)
+                moveKey(right->keys[i], right->keys[i - 1]);
+            for(size_type i = 1; i <= right->count; i++)
+                right->children[i - 1] = right->children[i];
+            right->count--;
+        }
+        else if(left != nullptr)
+        {
+            mergeInner(left, storedKey(parent->keys[index - 1]), child);
+            removeChild(parent, index - 1);
+        }
+        else
+        {
+            mergeInner(child, storedKey(parent->keys[index]), right);
+            removeChild(parent, index);
+        }
+    }
+
+    // Removes key from the subtree of node, returns whether node is left with too few entries.
+    bool eraseFrom(Node *node, size_type level, const key_type& key)
+    {
+        if(level == 0)
+        {
+            Leaf *leaf = static_cast<Leaf*>(node);
+            size_type index = lowerBound(leaf, key);
+            element(leaf, index).~value_type();             // key may refer to this element, it is not used below
+            for(size_type i = index + 1; i < leaf->count; i++)
+                moveElement(leaf, i, leaf, i - 1);
+            leaf->count--;
+            size--;
+            return leaf->count < minLeafCount;
+        }
+
+        Inner *inner = static_cast<Inner*>(node);
+        size_type index = childIndex(inner, key);
+        if(eraseFrom(inner->children[index], level - 1, key))
+        {
+            if(level == 1)
+                rebalanceLeaf(inner, index);
+            else
+                rebalanceInner(inner, index);
+        }
+        return inner->count < minKeys;
+    }
+
+    void deallocNode(Node *node, size_type level)
+    {
+        if(level == 0)
+        {
+            Leaf *leaf = static_cast<Leaf*>(node);
+            for(size_type i = 0; i < leaf->count; i++)
+                element(leaf, i).~value_type();
+            destroyLeaf(leaf);
+            return;
+        }
+
+        Inner *inner = static_cast<Inner*>(node);
+        for(size_type i = 0; i <= inner->count; i++)
+            deallocNode(inner->children[i], level - 1);
+        destroyInner(inner);
+    }
+
+    static size_type innerNodes(const Node *node, size_type level)
+    {
+        if(level == 0)
+            return 0;
+
+        const Inner *inner = static_cast<const Inner*>(node);
+        size_type count = 1;
+        for(size_type i = 0; i <= inner->count; i++)
+            count += innerNodes(inner->children[i], level - 1);
+        return count;
+    }
+
+    Node * cloneNode(const Node *node, size_type level) // leaves get appended to the leaf list
+    {
+        if(level == 0)
+        {
+            const Leaf *leaf = static_cast<const Leaf*>(node);
+            Leaf *copy = createLeaf();
+            try
+            {
+                for(; copy->count < leaf->count; copy->count++)
+                    new (copy->slots + copy->count) value_type(element(leaf, copy->count));
+            }
+            catch(...)
+            {
+                deallocNode(copy, 0);
+                throw;
+            }
+            copy->prev = lastLeaf;
+            if(lastLeaf != nullptr)
+                lastLeaf->next = copy;
+            else
+                firstLeaf = copy;
+            lastLeaf = copy;
+            return copy;
+        }
+
+        const Inner *inner = static_cast<const Inner*>(node);
+        Inner *copy = createInner();
+        size_type cloned = 0;
+        try
+        {
+            for(; copy->count < inner->count; copy->count++)
+                new (copy->keys + copy->count) key_type(storedKey(inner->keys[copy->count]));
+            for(; cloned <= inner->count; cloned++)
+                copy->children[cloned] = cloneNode(inner->children[cloned], level - 1);
+        }
+        catch(...)
+        {
+            for(size_type i = 0; i < cloned; i++)
+                deallocNode(copy->children[i], level - 1);
+            destroyInner(copy);
+            throw;
+        }
+        return copy;
+    }
+
+    void copyFrom(const BPlusTree& other) // this is empty, and stays so if copying throws
+    {
+        if(other.root == nullptr)
+            return;
+        try
+        {
+            root = cloneNode(other.root, other.height);
+        }
+        catch(...)
+        {
+            firstLeaf = nullptr;    // the leaves cloned so far are freed already
+            lastLeaf = nullptr;
+            throw;
+        }
+        height = other.height;
+        size = other.size;
+    }
+
+    void stealFrom(BPlusTree& other)
+    {
+        root = other.root;
+        firstLeaf = other.firstLeaf;
+        lastLeaf = other.lastLeaf;
+        height = other.height;
+        size = other.size;
+        leafAllocator = other.leafAllocator;    // the nodes belong to them
+        innerAllocator = other.innerAllocator;
+        other.root = nullptr;
+        other.firstLeaf = nullptr;
+        other.lastLeaf = nullptr;
+        other.height = 0;
+        other.size = 0;
+    }
+
+    void dealloc()
+    {
+        if(root != nullptr)
+            deallocNode(root, height);
+        root = nullptr;
+        firstLeaf = nullptr;
+        lastLeaf = nullptr;
+        height = 0;
+        size = 0;
+    }
+
+    template <typename ForwardIterator>
+    void buildSorted(ForwardIterator next, size_type count) // this is empty, it is left so if building throws
+    {
+        if(count == 0)
+            return;
+
+        std::vector<Node*> level;                   // nodes of the level being built, left to right
+        std::vector<const key_type*> firstKeys;     // smallest key under each of them
+        std::vector<Inner*> inners;                 // every inner node made so far, to free them on failure
+        size_type leafCount = (count + leafCapacity - 1) / leafCapacity;
+        try
+        {
+            for(size_type i = 0; i < leafCount; i++) // leaves as full as possible, elements spread evenly
+            {
+                Leaf *leaf = createLeaf();
+                leaf->prev = lastLeaf;
+                if(lastLeaf != nullptr)
+                    lastLeaf->next = leaf;
+                else
+                    firstLeaf = leaf;
+                lastLeaf = leaf;
+
+                size_type elements = count / leafCount + (i < count % leafCount ? 1 : 0);
+                for(; leaf->count < elements; ++next)
+                {
+                    new (leaf->slots + leaf->count) value_type((*next).first, (*next).second);
+                    leaf->count++;
+                }
+                level.push_back(leaf);
+                firstKeys.push_back(&element(leaf, 0).first);
+            }
+
+            while(level.size() > 1) // every inner level spreads its children evenly, the same way
+            {
+                size_type parentCount = (level.size() + maxChildren - 1) / maxChildren;
+                std::vector<Node*> parents;
+                std::vector<const key_type*> parentKeys;
+                inners.reserve(inners.size() + parentCount);
+                size_type child = 0;
+                for(size_type i = 0; i < parentCount; i++)
+                {
+                    Inner *inner = createInner();
+                    inners.push_back(inner);
+                    size_type children = level.size() / parentCount + (i < level.size() % parentCount ? 1 : 0);
+                    parentKeys.push_back(firstKeys[child]);
+                    inner->children[0] = level[child++];
+                    for(; inner->count + 1 < children; inner->count++)
+                    {
+                        new (inner->keys + inner->count) key_type(*firstKeys[child]);
+                        inner->children[inner->count + 1] = level[child++];
+                    }
+                    parents.push_back(inner);
+                }
+                level.swap(parents);
+                firstKeys.swap(parentKeys);
+                height++;
+            }
+        }
+        catch(...)
+        {
+            for(Inner *inner : inners)
+                destroyInner(inner);
+            while(firstLeaf != nullptr)
+            {
+                Leaf *leaf = firstLeaf;
+                firstLeaf = leaf->next;
+                deallocNode(leaf, 0);
+            }
+            lastLeaf = nullptr;
+            height = 0;
+            throw;
+        }
+        root = level.front();
+        size = count;
+    }
+
+public:
+    BPlusTree()
+    : root(nullptr), firstLeaf(nullptr), lastLeaf(nullptr), height(0), size(0)
+    {}
+
+    BPlusTree(const BPlusTree& other)
+    : root(nullptr), firstLeaf(nullptr), lastLeaf(nullptr), height(0), size(0),
+      leafAllocator(std::allocator_traits<LeafAllocator>::select_on_container_copy_construction(other.leafAllocator)),
+      innerAllocator(std::allocator_traits<InnerAllocator>::select_on_container_copy_construction(other.innerAllocator))
+    {
+        copyFrom(other);
+    }
+
+    BPlusTree(BPlusTree&& other)
+    : leafAllocator(other.leafAllocator), innerAllocator(other.innerAllocator)
+    {
+        stealFrom(other);
+    }
+
+    ~BPlusTree()
+    {
+        dealloc();
+    }
+
+    BPlusTree& operator=(const BPlusTree& other)
+    {
+        if(&other == this)
+            return *this;
+
+        BPlusTree copy(other); // this tree stays untouched if copying throws
+        return *this = std::move(copy);
+    }
+
+    BPlusTree& operator=(BPlusTree&& other)
+    {
+        if(&other == this)
+            return *this;
+
+        dealloc();
+        stealFrom(other);
+        return *this;
+    }
+
+    size_type getSize() const
+    {
+        return size;
+    }
+
+    Handle endHandle() const
+    {
+        return Handle{nullptr, 0};
+    }
+
+    Handle first() const
+    {
+        return Handle{firstLeaf, 0};
+    }
+
+    Handle next(Handle position) const
+    {
+        if(++position.index < position.leaf->count)
+            return position;
+        return Handle{position.leaf->next, 0};
+    }
+
+    Handle prev(Handle position) const // the end for first(), the tree must not be empty
+    {
+        if(position.leaf == nullptr)
+            return Handle{lastLeaf, lastLeaf->count - 1};
+        if(position.index > 0)
+            return Handle{position.leaf, position.index - 1};
+        if(position.leaf->prev == nullptr)
+            return endHandle();
+        return Handle{position.leaf->prev, position.leaf->prev->count - 1};
+    }
+
+    const value_type& get(const Handle& position) const
+    {
+        return element(position.leaf, position.index);
+    }
+
+    value_type& get(const Handle& position)
+    {
+        return element(position.leaf, position.index);
+    }
+
+    template <typename LookupKey>
+    Handle find(const LookupKey& key) const
+    {
+        if(size == 0)
+            return endHandle();
+
+        Leaf *leaf = const_cast<Leaf*>(findLeaf(key));
+        size_type index = lowerBound(leaf, key);
+        if(index < leaf->count && element(leaf, index).first == key)
+            return Handle{leaf, index};
+        return endHandle();
+    }
+
+    // Constructs the value from args if key is missing, key is moved in when passed as an rvalue.
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplace(Key&& key, Args&&... args)
+    {
+        if(root == nullptr)
+        {
+            firstLeaf = lastLeaf = createLeaf();
+            root = firstLeaf;
+            height = 0;
+        }
+
+        Node *right;
+        KeySlot separator;      // constructed only when the root is split
+        bool inserted;
+        Inner *reserved = nullptr;  // for the split, used up by it
+        Handle position;
+        try
+        {
+            position = insertInto(root, height, std::forward<Key>(key), right, separator, inserted, 1, reserved,
+                                  std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            releaseInners(reserved);
+            if(size == 0) // the leaf made for the first element is dropped
+            {
+                destroyLeaf(static_cast<Leaf*>(root));
+                root = nullptr;
+                firstLeaf = nullptr;
+                lastLeaf = nullptr;
+            }
+            throw;
+        }
+        if(right != nullptr) // root was split, the tree grows by one level
+        {
+            Inner *newRoot = takeInner(reserved);
+            moveKey(separator, newRoot->keys[0]);
+            newRoot->children[0] = root;
+            newRoot->children[1] = right;
+            newRoot->count = 1;
+            root = newRoot;
+            height++;
+        }
+        return std::make_pair(position, inserted);
+    }
+
+    Handle findOrInsert(const key_type& key) // inserts a value initialized value if key is missing
+    {
+        return tryEmplace(key).first;
+    }
+
+    template <typename ForwardIterator>
+    void assignSorted(ForwardIterator next, size_type count) // count elements with strictly increasing keys
+    {
+        BPlusTree built;    // aside, the current elements are only freed once it is complete
+        built.leafAllocator = leafAllocator;
+        built.innerAllocator = innerAllocator;
+        built.buildSorted(next, count);
+        *this = std::move(built);
+    }
+
+    void erase(const Handle& position)
+    {
+        eraseFrom(root, height, element(position.leaf, position.index).first);
+
+        if(height > 0 && root->count == 0) // root with a single child is dropped
+        {
+            Inner *oldRoot = static_cast<Inner*>(root);
+            root = oldRoot->children[0];
+            destroyInner(oldRoot);
+            height--;
+        }
+        else if(height == 0 && root->count == 0)
+        {
+            destroyLeaf(static_cast<Leaf*>(root));
+            root = nullptr;
+            firstLeaf = nullptr;
+            lastLeaf = nullptr;
+        }
+    }
+
+    MemoryUsage memoryUsage() const // O(size / fanout)
+    {
+        MemoryUsage usage{sizeof(*this), size * sizeof(value_type)};
+        for(const Leaf *leaf = firstLeaf; leaf != nullptr; leaf = leaf->next)
+            usage.allocated += sizeof(Leaf);
+        if(root != nullptr)
+            usage.allocated += innerNodes(root, height) * sizeof(Inner);
+        return usage;
+    }
+};
+
+template <std::size_t Fanout = 0>
+struct BPlus // TreeMap policy
+{
+    template <typename KeyType, typename ValueType, typename Allocator>
+    using Tree = BPlusTree<KeyType, ValueType, Fanout, Allocator>;
+};
+
+}
+
+#endif /* AISDI_MAPS_BPLUSTREE_H */
@@ -0,0 +1,391 @@
+#ifndef AISDI_MAPS_BENCHMARK_H
+#define AISDI_MAPS_BENCHMARK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "PerfCounters.h"
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+// Makes the compiler assume value is read, so computing it cannot be optimized away.
+template <typename Type>
+inline void doNotOptimize(const Type& value)
+{
+    __asm__ __volatile__("" : : "r,m"(value) : "memory");
+}
+
+// Makes the compiler assume all memory is read and written, so pending stores cannot be dropped.
+inline void clobberMemory()
+{
+    __asm__ __volatile__("" : : : "memory");
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Allocations
+{
+    std::size_t count;
+    std::size_t bytes;
+};
+
+// Heap allocations of the whole process so far. They are only counted where the program replaces the global
+// operator new to call countAllocation(), as the benchmark's main.cpp does, elsewhere they stay zero.
+inline std::atomic<std::size_t>& allocationCount()
+{
+    static std::atomic<std::size_t> count(0);
+    return count;
+}
+
+inline std::atomic<std::size_t>& allocatedBytes()
+{
+    static std::atomic<std::size_t> bytes(0);
+    return bytes;
+}
+
+inline void countAllocation(std::size_t bytes)
+{
+    allocationCount().fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes().fetch_add(bytes, std::memory_order_relaxed);
+}
+
+inline Allocations allocationsSoFar()
+{
+    return Allocations{allocationCount().load(std::memory_order_relaxed),
+                       allocatedBytes().load(std::memory_order_relaxed)};
+}
+
+// Peak resident set size of the process in bytes from /proc/self/status, 0 where it cannot be read.
+inline std::size_t peakResidentBytes()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line))
+        if(line.compare(0, 6, "VmHWM:") == 0)
+            return static_cast<std::size_t>(std::strtoull(line.c_str() + 6, nullptr, 10)) * 1024;
+    return 0;
+}
+
+// Lowers the peak resident set size to the current one, so that it can be measured per case.
+// Returns false where the kernel does not support it, the peak is then the process's since it started.
+inline bool resetPeakResident()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    return static_cast<bool>(clearRefs << "5") && static_cast<bool>(clearRefs.flush());
+}
+
+// Sums the time between start() and stop() pairs, setup outside them is not measured.
+// Allocations and, given counters, hardware events are only counted between start() and stop() as well.
+class Timer
+{
+    Clock::time_point started;
+    Clock::duration total;
+    bool running;
+    PerfCounters * counters;
+    Allocations allocationsAtStart;
+    Allocations allocated;
+
+public:
+    explicit Timer(PerfCounters *counters = nullptr)
+    : total(Clock::duration::zero()), running(false), counters(counters), allocationsAtStart{0, 0}, allocated{0, 0}
+    {}
+
+    void start()
+    {
+        if(running)
+            throw std::logic_error("Attempt to start a running timer.");
+        running = true;
+        allocationsAtStart = allocationsSoFar();
+        if(counters != nullptr)
+            counters->enable();
+        started = Clock::now();
+    }
+
+    void stop()
+    {
+        auto stopped = Clock::now();
+        if(counters != nullptr)
+            counters->disable();
+        if(!running)
+            throw std::logic_error("Attempt to stop a timer that is not running.");
+        running = false;
+        total += stopped - started;
+        Allocations now = allocationsSoFar();
+        allocated.count += now.count - allocationsAtStart.count;
+        allocated.bytes += now.bytes - allocationsAtStart.bytes;
+    }
+
+    double nanoseconds() const
+    {
+        return std::chrono::duration<double, std::nano>(total).count();
+    }
+
+    Allocations allocations() const
+    {
+        return allocated;
+    }
+};
+
+struct Counts // of one run
+{
+    std::size_t operations;     // timed
+    std::size_t distinctKeys;   // the workload really has, 0 if it has no keys
+    std::size_t containerBytes; // memoryUsage().allocated of the container the run built, 0 if not measured
+
+    Counts(std::size_t operations, std::size_t distinctKeys = 0, std::size_t containerBytes = 0)
+    : operations(operations), distinctKeys(distinctKeys), containerBytes(containerBytes)
+    {}
+};
+
+struct Case
+{
+    std::string name;                           // "Container/operation/distribution/size"
+    std::function<Counts(Timer&)> body;         // one run, starts and stops the timer
+    std::function<void()> release;              // optional, frees data the runs shared once the case is done
+};
+
+struct Statistics // of run times in nanoseconds
+{
+    std::size_t runs;
+    double minimum;
+    double median;
+    double p99;
+    double mean;
+};
+
+inline double percentile(const std::vector<double>& sorted, double fraction) // nearest rank
+{
+    auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+inline Statistics summarize(std::vector<double> samples)
+{
+    if(samples.empty())
+        throw std::invalid_argument("Attempt to summarize no samples.");
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for(double sample : samples)
+        sum += sample;
+
+    Statistics statistics;
+    statistics.runs = samples.size();
+    statistics.minimum = samples.front();
+    statistics.median = samples.size() % 2 == 1 ? samples[samples.size() / 2]
+                        : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+    statistics.p99 = percentile(samples, 0.99);
+    statistics.mean = sum / samples.size();
+    return statistics;
+}
+
+struct Result
+{
+    std::string name;
+    std::size_t operations;
+    std::size_t distinctKeys;
+    Statistics time;
+    std::vector<double> samples;    // run times in nanoseconds, in the order they were measured
+    std::vector<std::pair<std::string, double>> counters;  // events per operation, averaged over the runs
+    Allocations allocations;        // while timed, in the last run
+    std::size_t peakResident;       // bytes, highest resident set size while the case ran
+    std::size_t containerBytes;
+
+    double allocationsPerOperation() const
+    {
+        return operations == 0 ? 0.0 : static_cast<double>(allocations.count) / operations;
+    }
+
+    double nanosecondsPerOperation() const
+    {
+        return operations == 0 ? 0.0 : time.median / operations;
+    }
+};
+
+enum class Format
+{
+    text,
+    json,
+    csv
+};
+
+struct Options
+{
+    std::vector<std::string> filters;   // a case runs if its name contains any of them, all run if empty,
+                                        // a filter ending with '$' has to match the end of the name
+    std::size_t warmups = 1;
+    std::size_t repetitions = 5;
+    std::uint64_t seed = 20170503;      // of the key generators
+    bool listOnly = false;
+    bool counters = false;              // read hardware performance counters around the measured code
+    Format format = Format::text;
+    std::string baseline;               // CSV results to compare against, none if empty
+    double threshold = 0.05;            // smallest relative change of the median reported as a regression
+    double significance = 0.05;         // largest p-value reported as a regression
+};
+
+inline std::size_t parseCount(const std::string& option, const std::string& value)
+{
+    char *end = nullptr;
+    unsigned long long count = std::strtoull(value.c_str(), &end, 10);
+    if(value.empty() || *end != '\0')
+        throw std::invalid_argument("Option " + option + " expects a number, got: " + value);
+    return static_cast<std::size_t>(count);
+}
+
+// The whole of value as a number from lowest to highest, what names the value in the error.
+inline double parseNumber(const std::string& what, const std::string& value,
+                          double lowest = -std::numeric_limits<double>::max(),
+                          double highest = std::numeric_limits<double>::max())
+{
+    char *end = nullptr;
+    double number = std::strtod(value.c_str(), &end);
+    if(value.empty() || *end != '\0' || !(number >= lowest && number <= highest))
+        throw std::invalid_argument(what + " expects a number in its range, got: " + value);
+    return number;
+}
+
+inline Options parseOptions(int argc, char *argv[])
+{
+    Options options;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        auto separator = argument.find('=');
+        std::string option = argument.substr(0, separator);
+        std::string value = separator == std::string::npos ? "" : argument.substr(separator + 1);
+
+        if(option == "--filter")
+        {
+            std::size_t begin = 0, comma;
+            do
+            {
+                comma = value.find(',', begin);
+                options.filters.push_back(value.substr(begin, comma - begin));
+                begin = comma + 1;
+            }
+            while(comma != std::string::npos);
+        }
+        else if(option == "--warmup")
+            options.warmups = parseCount(option, value);
+        else if(option == "--repetitions")
+        {
+            options.repetitions = parseCount(option, value);
+            if(options.repetitions == 0)
+                throw std::invalid_argument("At least one repetition is needed.");
+        }
+        else if(option == "--seed")
+            options.seed = parseCount(option, value);
+        else if(option == "--list")
+            options.listOnly = true;
+        else if(option == "--counters")
+            options.counters = true;
+        else if(option == "--format")
+        {
+            if(value == "text")
+                options.format = Format::text;
+            else if(value == "json")
+                options.format = Format::json;
+            else if(value == "csv")
+                options.format = Format::csv;
+            else
+                throw std::invalid_argument("Unknown format: " + value);
+        }
+        else if(option == "--baseline")
+        {
+            if(value.empty())
+                throw std::invalid_argument("Option --baseline expects a file name.");
+            options.baseline = value;
+        }
+        else if(option == "--threshold")
+            options.threshold = parseNumber("Option " + option, value, 0.0, 1000.0) / 100.0;
+        else if(option == "--significance")
+            options.significance = parseNumber("Option " + option, value, 0.0, 1.0);
+        else
+            throw std::invalid_argument("Unknown option: " + argument);
+    }
+    return options;
+}
+
+inline bool isSelected(const Case& benchmarkCase, const Options& options)
+{
+    if(options.filters.empty())
+        return true;
+    const std::string& name = benchmarkCase.name;
+    for(const auto& filter : options.filters)
+    {
+        if(!filter.empty() && filter.back() == '$')
+        {
+            std::size_t length = filter.size() - 1;
+            if(name.size() >= length && name.compare(name.size() - length, length, filter, 0, length) == 0)
+                return true;
+        }
+        else if(name.find(filter) != std::string::npos)
+            return true;
+    }
+    return false;
+}
+
+inline Result runCase(const Case& benchmarkCase, const Options& options, PerfCounters *counters = nullptr)
+{
+    resetPeakResident();
+    for(std::size_t i = 0; i < options.warmups; i++)
+    {
+        Timer timer;
+        benchmarkCase.body(timer);
+    }
+
+    std::vector<double> samples;
+    std::vector<double> events;
+    Counts counts(0);
+    Allocations allocations{0, 0};
+    for(std::size_t i = 0; i < options.repetitions; i++)
+    {
+        if(counters != nullptr)
+            counters->reset();
+        Timer timer(counters);
+        counts = benchmarkCase.body(timer);
+        samples.push_back(timer.nanoseconds());
+        allocations = timer.allocations();
+        if(counters != nullptr)
+        {
+            auto values = counters->read();
+            events.resize(values.size());
+            for(std::size_t j = 0; j < values.size(); j++)
+                events[j] += values[j];
+        }
+    }
+    std::size_t peakResident = peakResidentBytes();
+    if(benchmarkCase.release)
+        benchmarkCase.release();
+
+    Result result{benchmarkCase.name, counts.operations, counts.distinctKeys, summarize(samples), samples, {},
+                  allocations, peakResident, counts.containerBytes};
+    if(counters != nullptr)
+    {
+        auto names = counters->names();
+        double operations = static_cast<double>(std::max<std::size_t>(counts.operations, 1) * options.repetitions);
+        for(std::size_t j = 0; j < events.size(); j++)
+            result.counters.emplace_back(names[j], events[j] / operations);
+    }
+    return result;
+}
+
+}
+}
+
+#endif /* AISDI_MAPS_BENCHMARK_H */
@@ -0,0 +1,339 @@
+#ifndef AISDI_MAPS_BENCHMARKREPORT_H
+#define AISDI_MAPS_BENCHMARKREPORT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+inline std::string jsonString(const std::string& text)
+{
+    std::ostringstream out;
+    out << '"';
+    for(char c : text)
+    {
+        if(c == '"' || c == '\\')
+            out << '\\' << c;
+        else if(static_cast<unsigned char>(c) < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        else
+            out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+// Counter columns only appear in the text table, the other formats name the counters in every result.
+inline void printHeader(std::ostream& out, Format format, const std::vector<std::string>& counterNames = {})
+{
+    switch(format)
+    {
+    case Format::text:
+        out << std::left << std::setw(44) << "Case" << std::right << std::setw(10) << "keys"
+            << std::setw(14) << "median [ns]" << std::setw(14) << "p99 [ns]"
+            << std::setw(14) << "min [ns]" << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op"
+            << std::setw(16) << "peak RSS [MiB]" << std::setw(12) << "bytes/key";
+        for(const auto& name : counterNames)
+            out << std::setw(18) << name + "/op";
+        out << '\n';
+        break;
+    case Format::json:
+        out << "{\n  \"results\": [";
+        break;
+    case Format::csv:   // samples and counters are separated with ';', case names never contain ',' or ';'
+        out << "name,distinct_keys,operations,runs,min_ns,median_ns,p99_ns,mean_ns,ns_per_op,samples_ns,"
+               "counters_per_op,allocations,allocated_bytes,peak_rss_bytes,container_bytes\n";
+        break;
+    }
+}
+
+inline void printResult(std::ostream& out, const Result& result, Format format, bool first)
+{
+    out << std::fixed << std::setprecision(0);
+    switch(format)
+    {
+    case Format::text:
+        out << std::left << std::setw(44) << result.name << std::right << std::setw(10) << result.distinctKeys
+            << std::setw(14) << result.time.median << std::setw(14) << result.time.p99
+            << std::setw(14) << result.time.minimum
+            << std::setprecision(2) << std::setw(12) << result.nanosecondsPerOperation()
+            << std::setw(12) << result.allocationsPerOperation()
+            << std::setprecision(1) << std::setw(16) << result.peakResident / (1024.0 * 1024.0);
+        if(result.containerBytes == 0 || result.distinctKeys == 0)
+            out << std::setw(12) << "-";
+        else
+            out << std::setw(12) << static_cast<double>(result.containerBytes) / result.distinctKeys;
+        out << std::setprecision(2);
+        for(const auto& counter : result.counters)
+            out << std::setw(18) << counter.second;
+        out << '\n';
+        break;
+    case Format::json:
+        out << (first ? "\n" : ",\n")
+            << "    { \"name\": " << jsonString(result.name) << ", \"distinct_keys\": " << result.distinctKeys
+            << ", \"operations\": " << result.operations << ", \"runs\": " << result.time.runs
+            << ", \"min_ns\": " << result.time.minimum << ", \"median_ns\": " << result.time.median
+            << ", \"p99_ns\": " << result.time.p99 << ", \"mean_ns\": " << result.time.mean
+            << std::setprecision(3) << ", \"ns_per_op\": " << result.nanosecondsPerOperation()
+            << std::setprecision(0) << ", \"samples_ns\": [";
+        for(std::size_t i = 0; i < result.samples.size(); i++)
+            out << (i == 0 ? "" : ", ") << result.samples[i];
+        out << "], \"allocations\": " << result.allocations.count
+            << ", \"allocated_bytes\": " << result.allocations.bytes
+            << ", \"peak_rss_bytes\": " << result.peakResident
+            << ", \"container_bytes\": " << result.containerBytes << std::setprecision(3);
+        if(!result.counters.empty())
+        {
+            out << ", \"counters_per_op\": {";
+            for(std::size_t i = 0; i < result.counters.size(); i++)
+                out << (i == 0 ? " " : ", ") << jsonString(result.counters[i].first)
+                    << ": " << result.counters[i].second;
+            out << " }";
+        }
+        out << " }";
+        break;
+    case Format::csv:
+        out << result.name << ',' << result.distinctKeys << ',' << result.operations << ',' << result.time.runs
+            << ',' << result.time.minimum << ',' << result.time.median << ',' << result.time.p99
+            << ',' << result.time.mean << ',' << std::setprecision(3) << result.nanosecondsPerOperation()
+            << std::setprecision(0) << ',';
+        for(std::size_t i = 0; i < result.samples.size(); i++)
+            out << (i == 0 ? "" : ";") << result.samples[i];
+        out << ',' << std::setprecision(3);
+        for(std::size_t i = 0; i < result.counters.size(); i++)
+            out << (i == 0 ? "" : ";") << result.counters[i].first << '=' << result.counters[i].second;
+        out << ',' << result.allocations.count << ',' << result.allocations.bytes
+            << ',' << result.peakResident << ',' << result.containerBytes << '\n';
+        break;
+    }
+}
+
+inline void printFooter(std::ostream& out, Format format)
+{
+    if(format == Format::json)
+        out << "\n  ]\n}\n";
+}
+
+// Runs the selected cases one after another, results are printed as soon as each case finishes.
+inline std::vector<Result> runCases(const std::vector<Case>& cases, const Options& options, std::ostream& out,
+                                    PerfCounters *counters = nullptr)
+{
+    std::vector<Result> results;
+    if(options.listOnly)
+    {
+        for(const auto& benchmarkCase : cases)
+            if(isSelected(benchmarkCase, options))
+                out << benchmarkCase.name << '\n';
+        return results;
+    }
+
+    printHeader(out, options.format, counters == nullptr ? std::vector<std::string>() : counters->names());
+    for(const auto& benchmarkCase : cases)
+        if(isSelected(benchmarkCase, options))
+        {
+            results.push_back(runCase(benchmarkCase, options, counters));
+            printResult(out, results.back(), options.format, results.size() == 1);
+            out.flush();
+        }
+    printFooter(out, options.format);
+    return results;
+}
+
+inline std::vector<std::string> split(const std::string& text, char separator)
+{
+    std::vector<std::string> fields;
+    std::size_t begin = 0, end;
+    do
+    {
+        end = text.find(separator, begin);
+        fields.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    while(end != std::string::npos);
+    return fields;
+}
+
+inline std::size_t parseCountField(const std::string& text)
+{
+    return static_cast<std::size_t>(parseNumber("A count", text, 0.0));
+}
+
+// Reads results written with Format::csv.
+inline std::vector<Result> loadResults(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    if(!in)
+        throw std::runtime_error("Cannot open " + fileName);
+
+    std::vector<Result> results;
+    std::string line;
+    std::size_t lineNumber = 0;
+    while(std::getline(in, line))
+    {
+        if(++lineNumber == 1 || line.empty())
+            continue;
+        try
+        {
+            auto fields = split(line, ',');
+            if(fields.size() != 15)
+                throw std::runtime_error("Expected 15 fields, got " + std::to_string(fields.size()));
+
+            Result result{};
+            result.name = fields[0];
+            result.distinctKeys = parseCountField(fields[1]);
+            result.operations = parseCountField(fields[2]);
+            for(const auto& sample : split(fields[9], ';'))
+                result.samples.push_back(parseNumber("A sample", sample, 0.0));
+            result.time = summarize(result.samples);
+            if(!fields[10].empty())
+                for(const auto& counter : split(fields[10], ';'))
+                {
+                    auto separator = counter.find('=');
+                    if(separator == std::string::npos)
+                        throw std::runtime_error("Expected name=value, got: " + counter);
+                    result.counters.emplace_back(counter.substr(0, separator), parseNumber("A counter", counter.substr(separator + 1)));
+                }
+            result.allocations.count = parseCountField(fields[11]);
+            result.allocations.bytes = parseCountField(fields[12]);
+            result.peakResident = parseCountField(fields[13]);
+            result.containerBytes = parseCountField(fields[14]);
+            results.push_back(result);
+        }
+        catch(const std::exception& error)
+        {
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": " + error.what());
+        }
+    }
+    if(lineNumber == 0)
+        throw std::runtime_error(fileName + " is empty.");
+    return results;
+}
+
+// Two-sided p-value of the Mann-Whitney U test that both samples come from the same distribution,
+// from the normal approximation with tie and continuity corrections.
+// Needs about five runs on each side to ever get below 0.05.
+inline double mannWhitneyPValue(const std::vector<double>& first, const std::vector<double>& second)
+{
+    const double n1 = static_cast<double>(first.size()), n2 = static_cast<double>(second.size()), n = n1 + n2;
+    if(first.empty() || second.empty())
+        return 1.0;
+
+    std::vector<std::pair<double, bool>> pooled;    // sample, whether it comes from first
+    for(double sample : first)
+        pooled.emplace_back(sample, true);
+    for(double sample : second)
+        pooled.emplace_back(sample, false);
+    std::sort(pooled.begin(), pooled.end());
+
+    double firstRanks = 0.0, ties = 0.0;
+    for(std::size_t i = 0, j; i < pooled.size(); i = j)
+    {
+        for(j = i; j < pooled.size() && pooled[j].first == pooled[i].first; j++)
+            ;
+        double rank = (i + 1 + j) / 2.0;    // average of ranks i + 1 ... j
+        double tied = static_cast<double>(j - i);
+        ties += tied * tied * tied - tied;
+        for(std::size_t k = i; k < j; k++)
+            if(pooled[k].second)
+                firstRanks += rank;
+    }
+
+    double u = firstRanks - n1 * (n1 + 1) / 2;
+    double deviation = std::sqrt(n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1))));
+    if(deviation == 0.0)
+        return 1.0;
+    double z = std::max(std::fabs(u - n1 * n2 / 2) - 0.5, 0.0) / deviation;
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+enum class Verdict
+{
+    unchanged,
+    regression,
+    improvement,
+    added          // not in the baseline
+};
+
+struct Comparison
+{
+    std::string name;
+    double baselineMedian;
+    double currentMedian;
+    double change;          // of the median, relative to the baseline
+    double pValue;
+    Verdict verdict;
+};
+
+// A case regressed if its median grew by more than the threshold and the run times differ significantly.
+inline std::vector<Comparison> compare(const std::vector<Result>& baseline, const std::vector<Result>& current,
+                                       const Options& options)
+{
+    std::vector<Comparison> comparisons;
+    for(const auto& result : current)
+    {
+        auto old = std::find_if(baseline.begin(), baseline.end(),
+                                [&result](const Result& candidate) { return candidate.name == result.name; });
+        if(old == baseline.end())
+        {
+            comparisons.push_back(Comparison{result.name, 0.0, result.time.median, 0.0, 1.0, Verdict::added});
+            continue;
+        }
+
+        double change = old->time.median == 0.0 ? 0.0 : result.time.median / old->time.median - 1.0;
+        double pValue = mannWhitneyPValue(old->samples, result.samples);
+        Verdict verdict = Verdict::unchanged;
+        if(pValue <= options.significance && change > options.threshold)
+            verdict = Verdict::regression;
+        else if(pValue <= options.significance && change < -options.threshold)
+            verdict = Verdict::improvement;
+        comparisons.push_back(Comparison{result.name, old->time.median, result.time.median, change, pValue, verdict});
+    }
+    return comparisons;
+}
+
+inline const char * verdictName(Verdict verdict)
+{
+    switch(verdict)
+    {
+    case Verdict::regression:
+        return "REGRESSION";
+    case Verdict::improvement:
+        return "improvement";
+    case Verdict::added:
+        return "new";
+    default:
+        return "";
+    }
+}
+
+inline void printComparisons(std::ostream& out, const std::vector<Comparison>& comparisons)
+{
+    out << std::left << std::setw(44) << "Case" << std::right << std::setw(16) << "baseline [ns]"
+        << std::setw(14) << "median [ns]" << std::setw(10) << "change" << std::setw(8) << "p" << "  verdict\n";
+    for(const auto& comparison : comparisons)
+    {
+        out << std::left << std::setw(44) << comparison.name << std::right << std::fixed << std::setprecision(0)
+            << std::setw(16) << comparison.baselineMedian << std::setw(14) << comparison.currentMedian
+            << std::setprecision(1) << std::setw(9) << comparison.change * 100 << '%'
+            << std::setprecision(3) << std::setw(8) << comparison.pValue
+            << "  " << verdictName(comparison.verdict) << '\n';
+    }
+}
+
+}
+}
+
+#endif /* AISDI_MAPS_BENCHMARKREPORT_H */
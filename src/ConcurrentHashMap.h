@@ -0,0 +1,194 @@
+#ifndef AISDI_MAPS_CONCURRENTHASHMAP_H
+#define AISDI_MAPS_CONCURRENTHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "HashMap.h"
+
+namespace aisdi
+{
+
+// HashMap split into shards, each one a HashMap of its own behind its own mutex, so threads working on
+// different shards never wait for each other. The top bits of a key's hash pick its shard, the bottom ones
+// its bucket inside the shard, the key is hashed once for both. Values are handed out as copies or to
+// functions run under the shard's lock, never as references or iterators, which would outlive the lock.
+// Such functions must not use the map.
+// Every shard has an allocator of its own, so node pools are not shared between threads either.
+template <typename KeyType, typename ValueType, typename TablePolicy = ChainedBuckets,
+          typename Allocator = PoolAllocator<std::pair<const KeyType, ValueType>>, typename Hasher = Hash<KeyType>>
+class ConcurrentHashMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+    using hasher = Hasher;
+
+private:
+    using Map = HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher>;
+
+    enum : size_type
+    {
+        shardBits = 16,
+        maxShardCount = size_type{1} << shardBits
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        Map map;
+        char padding[64];   // keeps the next shard's mutex off the cache lines of this one
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_type shardCount;   // a power of two
+
+    Shard& shardOf(size_type hash) const
+    {
+        return shards[(hash >> (std::numeric_limits<size_type>::digits - shardBits)) & (shardCount - 1)];
+    }
+
+    static size_type defaultShardCount() // a few per core, so threads rarely meet on one
+    {
+        return 4 * std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+public:
+    explicit ConcurrentHashMap(size_type shardsWanted = defaultShardCount()) // rounded up to a power of two
+    : shardCount(1)
+    {
+        if(shardsWanted > maxShardCount)
+            throw std::invalid_argument("Shard count cannot exceed 65536.");
+        while(shardCount < shardsWanted)
+            shardCount *= 2;
+        shards.reset(new Shard[shardCount]);
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+    bool find(const key_type& key, mapped_type& value) const // copies the value out, false if key is missing
+    {
+        size_type hash = spreadHash<Hasher>(key);
+        Shard& shard = shardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.findHashed(key, hash);
+        if(it == shard.map.end())
+            return false;
+        value = it->second;
+        return true;
+    }
+
+    mapped_type valueOf(const key_type& key) const // a copy
+    {
+        size_type hash = spreadHash<Hasher>(key);
+        Shard& shard = shardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.findHashed(key, hash);
+        if(it == shard.map.end())
+            throw std::out_of_range("Attempt to get an element that is not in the map.");
+        return it->second;
+    }
+
+    template <typename... Args>
+    bool try_emplace(const key_type& key, Args&&... args) // true if key was added
+    {
+        size_type hash = spreadHash<Hasher>(key);
+        Shard& shard = shardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.map.tryEmplaceHashed(hash, key, std::forward<Args>(args)...).second;
+    }
+
+    template <typename Value>
+    bool insert_or_assign(const key_type& key, Value&& value) // true if key was added
+    {
+        size_type hash = spreadHash<Hasher>(key);
+        Shard& shard = shardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto result = shard.map.tryEmplaceHashed(hash, key, std::forward<Value>(value));
+        if(!result.second)
+            result.first->second = std::forward<Value>(value);
+        return result.second;
+    }
+
+    bool erase(const key_type& key) // false if key was missing
+    {
+        size_type hash = spreadHash<Hasher>(key);
+        Shard& shard = shardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.findHashed(key, hash);
+        if(it == shard.map.end())
+            return false;
+        shard.map.remove(it);
+        return true;
+    }
+
+    // Calls function with the key's value and returns what it returns, atomically with respect to every other
+    // operation on the key. A missing key is added with a value initialized value first.
+    template <typename Function>
+    auto compute(const key_type& key, Function function) -> decltype(function(std::declval<mapped_type&>()))
+    {
+        size_type hash = spreadHash<Hasher>(key);
+        Shard& shard = shardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return function(shard.map.tryEmplaceHashed(hash, key).first->second);
+    }
+
+    // Calls function with every element, shard after shard, each shard under its lock. There is no snapshot
+    // of the whole map: changes made meanwhile to shards visited earlier or later may or may not be seen.
+    template <typename Function>
+    void for_each(Function function) const
+    {
+        for(size_type i = 0; i < shardCount; i++)
+        {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            for(const auto& element : shards[i].map)
+                function(element);
+        }
+    }
+
+    size_type getSize() const // the shards are counted one after another, not at a single moment
+    {
+        size_type size = 0;
+        for(size_type i = 0; i < shardCount; i++)
+        {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            size += shards[i].map.getSize();
+        }
+        return size;
+    }
+
+    bool isEmpty() const
+    {
+        return getSize() == 0;
+    }
+
+    size_type shard_count() const
+    {
+        return shardCount;
+    }
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage{sizeof(*this) + shardCount * (sizeof(Shard) - sizeof(Map)), 0};
+        for(size_type i = 0; i < shardCount; i++)
+        {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            MemoryUsage shardUsage = shards[i].map.memoryUsage();
+            usage.allocated += shardUsage.allocated;
+            usage.payload += shardUsage.payload;
+        }
+        return usage;
+    }
+};
+
+}
+
+#endif /* AISDI_MAPS_CONCURRENTHASHMAP_H */
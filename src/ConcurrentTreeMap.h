@@ -0,0 +1,571 @@
+#ifndef AISDI_MAPS_CONCURRENTTREEMAP_H
+#define AISDI_MAPS_CONCURRENTTREEMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Epochs.h"
+#include "Hashing.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+// Ordered map for many threads, a lazy skip list (Herlihy, Lev, Luchangco, Shavit). Lookups and iteration
+// take no lock, inside an Epochs::ReadSection. Insertions and removals lock only the nodes in front of the
+// key on each of its levels and validate them before relinking. A removal first marks its node, which
+// is the moment it takes effect, and the node is freed by epochs once no reader can still be on it.
+// Elements never change once published: an assignment swaps in a new one under the node's lock.
+// Unlike TreeMap, remove(key) reports a missing key by its result, as checking first would be a race.
+template <typename KeyType, typename ValueType>
+class ConcurrentTreeMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+    using const_reference = const value_type&;
+
+    class ConstIterator;
+    using const_iterator = ConstIterator;
+
+private:
+    enum : size_type
+    {
+        maxHeight = 32  // levels are kept with probability 1/2, enough for 2^32 elements
+    };
+
+    // Held only while relinking a few nodes. A byte instead of std::mutex keeps a node's key and its lower
+    // links on one cache line, which matters more to searches than how waiting writers wait.
+    class SpinLock
+    {
+        std::atomic<bool> locked;
+
+    public:
+        SpinLock() : locked(false)
+        {}
+
+        void lock()
+        {
+            while(locked.exchange(true, std::memory_order_acquire))
+                while(locked.load(std::memory_order_relaxed))
+                    std::this_thread::yield();
+        }
+
+        void unlock()
+        {
+            locked.store(false, std::memory_order_release);
+        }
+    };
+
+    // Allocated by new (height) with room for its links after it. The key is kept next to the links, apart
+    // from the element, as searches compare it at every step. The head is the only node without either.
+    struct Node
+    {
+        std::atomic<const value_type*> element;
+        int height;
+        std::atomic<bool> marked;   // removed, set once under the mutex
+        std::atomic<bool> linked;   // on all of its levels, set once
+        SpinLock mutex;
+        typename std::aligned_storage<sizeof(key_type), alignof(key_type)>::type key;
+        std::atomic<Node*> next[1]; // height of them
+
+        static void * operator new(std::size_t size, int height)
+        {
+            return ::operator new(size + (height - 1) * sizeof(std::atomic<Node*>));
+        }
+
+        static void operator delete(void *pointer, int)
+        {
+            ::operator delete(pointer);
+        }
+
+        static void operator delete(void *pointer)
+        {
+            ::operator delete(pointer);
+        }
+
+        explicit Node(int height) : element(nullptr), height(height), marked(false), linked(false)
+        {
+            clearLinks();
+        }
+
+        Node(int height, const value_type *element) : element(element), height(height), marked(false), linked(false)
+        {
+            new (&key) key_type(element->first);
+            clearLinks();
+        }
+
+        ~Node()
+        {
+            const value_type *owned = element.load(std::memory_order_relaxed);
+            if(owned == nullptr)
+                return;
+            reinterpret_cast<key_type*>(&key)->~key_type();
+            delete owned;
+        }
+
+        const value_type * takeElement() // leaves the node without element or key, only to be deleted
+        {
+            reinterpret_cast<key_type*>(&key)->~key_type();
+            return element.exchange(nullptr, std::memory_order_relaxed);
+        }
+
+        void clearLinks()
+        {
+            for(int level = 0; level < height; level++)
+                next[level].store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    Node *head;
+    std::atomic<int> levels;    // the highest height linked so far, searches start there
+    std::atomic<size_type> size;
+    mutable std::mutex retiredMutex;
+    RetiredList retired;    // removed nodes, guarded by retiredMutex
+    size_type reserved;     // entries of retired promised to removals under way, guarded by retiredMutex
+
+    static const key_type& keyOf(const Node *node) // node must not be the head
+    {
+        return *reinterpret_cast<const key_type*>(&node->key);
+    }
+
+    static int randomHeight()
+    {
+        static thread_local std::uint64_t state = mixHashBits(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        int height = 1;
+        for(std::uint64_t bits = state; (bits & 1) != 0 && height < static_cast<int>(maxHeight); bits >>= 1)
+            height++;
+        return height;
+    }
+
+    // Fills preds and succs with the nodes around key on every level, succs holding the key if it is there.
+    // Returns the highest level key was found on, -1 if it was not.
+    int search(const key_type& key, Node **preds, Node **succs) const // inside a read section
+    {
+        int found = -1;
+        int top = levels.load(std::memory_order_acquire);
+        for(int level = maxHeight - 1; level >= top; level--)
+        {
+            preds[level] = head;
+            succs[level] = nullptr;     // if that is no longer true, validation will tell
+        }
+
+        Node *pred = head;
+        for(int level = top - 1; level >= 0; level--)
+        {
+            Node *current = pred->next[level].load(std::memory_order_acquire);
+            while(current != nullptr && keyOf(current) < key)
+            {
+                pred = current;
+                current = pred->next[level].load(std::memory_order_acquire);
+            }
+            if(found == -1 && current != nullptr && !(key < keyOf(current)))
+                found = level;
+            preds[level] = pred;
+            succs[level] = current;
+        }
+        return found;
+    }
+
+    const Node * firstNotBelow(const key_type& key) const // inside a read section, may be marked or unlinked
+    {
+        const Node *pred = head;
+        const Node *current = nullptr;
+        for(int level = levels.load(std::memory_order_acquire) - 1; level >= 0; level--)
+        {
+            current = pred->next[level].load(std::memory_order_acquire);
+            while(current != nullptr && keyOf(current) < key)
+            {
+                pred = current;
+                current = pred->next[level].load(std::memory_order_acquire);
+            }
+        }
+        return current;
+    }
+
+    const Node * nodeOf(const key_type& key) const // inside a read section, null unless key is in the map
+    {
+        const Node *pred = head;
+        for(int level = levels.load(std::memory_order_acquire) - 1; level >= 0; level--)
+        {
+            const Node *current = pred->next[level].load(std::memory_order_acquire);
+            while(current != nullptr && keyOf(current) < key)
+            {
+                pred = current;
+                current = pred->next[level].load(std::memory_order_acquire);
+            }
+            if(current != nullptr && !(key < keyOf(current)))   // no need to go down any further
+                return current->linked.load(std::memory_order_acquire)
+                       && !current->marked.load(std::memory_order_acquire) ? current : nullptr;
+        }
+        return nullptr;
+    }
+
+    // Locks preds on the lowest height levels and checks that nothing changed around them since search().
+    // Locks are taken from the highest key down, as every writer takes them, so writers never deadlock.
+    static bool lockAndValidate(std::unique_lock<SpinLock> *locks, Node **preds, Node **succs, int height,
+                                bool succsMayBeMarked)
+    {
+        Node *previous = nullptr;
+        for(int level = 0; level < height; level++)
+        {
+            Node *pred = preds[level];
+            Node *succ = succs[level];
+            if(pred != previous)
+                locks[level] = std::unique_lock<SpinLock>(pred->mutex);
+            previous = pred;
+
+            if(pred->marked.load(std::memory_order_acquire) || pred->next[level].load(std::memory_order_acquire) != succ
+               || (!succsMayBeMarked && succ != nullptr && succ->marked.load(std::memory_order_acquire)))
+                return false;
+        }
+        return true;
+    }
+
+    // Inserts the element makeElement() returns if key is missing, otherwise calls found with key's node
+    // locked and unmarked. The new node is made before any lock is taken and kept over retries, found gets
+    // it too, as another thread may add key after it was made. Returns true if key was inserted.
+    template <typename MakeElement, typename Found>
+    bool insertOr(const key_type& key, MakeElement makeElement, Found found)
+    {
+        int height = randomHeight();
+        Node *preds[maxHeight];
+        Node *succs[maxHeight];
+        std::unique_ptr<Node> made;
+        Epochs::ReadSection section;
+        for(;;)
+        {
+            int level = search(key, preds, succs);
+            if(level != -1)
+            {
+                Node *node = succs[level];
+                while(!node->linked.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                std::unique_lock<SpinLock> lock(node->mutex);
+                if(node->marked.load(std::memory_order_relaxed))
+                {
+                    lock.unlock();
+                    std::this_thread::yield();  // being removed, retried until it is gone
+                    continue;
+                }
+                found(*node, made);
+                return false;
+            }
+
+            if(!made)
+            {
+                std::unique_ptr<const value_type> element(makeElement());
+                made.reset(new (height) Node(height, element.get()));
+                element.release();
+            }
+            std::unique_lock<SpinLock> locks[maxHeight];
+            if(!lockAndValidate(locks, preds, succs, height, false))
+                continue;
+
+            Node *node = made.release();
+            for(int top = levels.load(std::memory_order_relaxed);
+                top < height && !levels.compare_exchange_weak(top, height, std::memory_order_release,
+                                                              std::memory_order_relaxed);)
+                ;
+            for(level = 0; level < height; level++)
+                node->next[level].store(succs[level], std::memory_order_relaxed);
+            for(level = 0; level < height; level++)
+                preds[level]->next[level].store(node, std::memory_order_release);
+            node->linked.store(true, std::memory_order_release);
+            size.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    void reserveRetirement() // makes the matching retire() unable to throw
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired.reserve(reserved + 1);
+        reserved++;
+    }
+
+    void cancelRetirement()
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        reserved--;
+    }
+
+    void retire(Node *node) // a reserveRetirement() has to come first
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        reserved--;
+        retired.retire(node);
+    }
+
+public:
+    ConcurrentTreeMap() : head(new (maxHeight) Node(maxHeight)), levels(1), size(0), reserved(0)
+    {}
+
+    ConcurrentTreeMap(const ConcurrentTreeMap&) = delete;
+    ConcurrentTreeMap& operator=(const ConcurrentTreeMap&) = delete;
+
+    ~ConcurrentTreeMap() // nobody may be using the map any more
+    {
+        for(Node *node = head; node != nullptr;)
+        {
+            Node *next = node->next[0].load();
+            delete node;
+            node = next;
+        }
+    }
+
+    bool isEmpty() const
+    {
+        return getSize() == 0;
+    }
+
+    size_type getSize() const
+    {
+        return size.load(std::memory_order_relaxed);
+    }
+
+    bool find(const key_type& key, mapped_type& value) const // copies the value out, false if key is missing
+    {
+        Epochs::ReadSection section;
+        const Node *node = nodeOf(key);
+        if(node == nullptr)
+            return false;
+        value = node->element.load(std::memory_order_acquire)->second;
+        return true;
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        const_iterator it;
+        it.pointTo(nodeOf(key));
+        return it;
+    }
+
+    mapped_type valueOf(const key_type& key) const // a copy
+    {
+        Epochs::ReadSection section;
+        const Node *node = nodeOf(key);
+        if(node == nullptr)
+            throw std::out_of_range("Attempt to access an element that is not in the map.");
+        return node->element.load(std::memory_order_acquire)->second;
+    }
+
+    template <typename... Args>
+    bool try_emplace(const key_type& key, Args&&... args) // true if key was added
+    {
+        return insertOr(key, [&]()
+        {
+            return new value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+        }, [](Node&, std::unique_ptr<Node>&) {});
+    }
+
+    template <typename Value>
+    bool insert_or_assign(const key_type& key, Value&& value) // true if key was added
+    {
+        return insertOr(key, [&]() { return new value_type(key, std::forward<Value>(value)); },
+                        [&](Node& node, std::unique_ptr<Node>& made)
+        {
+            std::unique_ptr<const value_type> element(made ? made->takeElement()   // value was used up by it
+                                                           : new value_type(key, std::forward<Value>(value)));
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            retired.reserve(reserved + 1);
+            retired.retire(node.element.exchange(element.release(), std::memory_order_acq_rel));
+        });
+    }
+
+    bool remove(const key_type& key) // false if key was missing
+    {
+        Node *preds[maxHeight];
+        Node *succs[maxHeight];
+        Epochs::ReadSection section;
+        int level = search(key, preds, succs);
+        if(level == -1)
+            return false;
+
+        Node *victim = succs[level];
+        if(!victim->linked.load(std::memory_order_acquire) || victim->height - 1 != level)
+            return false;   // still being inserted, which takes effect once it is linked
+        reserveRetirement();    // nothing may throw once the victim is marked
+        bool removedElsewhere;
+        {
+            std::lock_guard<SpinLock> lock(victim->mutex);
+            removedElsewhere = victim->marked.load(std::memory_order_relaxed);
+            victim->marked.store(true, std::memory_order_release);
+        }
+        if(removedElsewhere)
+        {
+            cancelRetirement();
+            return false;
+        }
+
+        for(;; search(key, preds, succs))
+        {
+            std::unique_lock<SpinLock> locks[maxHeight];
+            for(int i = 0; i < victim->height; i++)
+                succs[i] = victim;
+            if(!lockAndValidate(locks, preds, succs, victim->height, true))
+                continue;
+
+            for(int i = victim->height - 1; i >= 0; i--)
+                preds[i]->next[i].store(victim->next[i].load(std::memory_order_relaxed), std::memory_order_release);
+            break;
+        }
+        size.fetch_sub(1, std::memory_order_relaxed);
+        retire(victim);
+        return true;
+    }
+
+    // Ascending from the smallest key, or from the smallest one not below key.
+    // Iterators are weakly consistent, see ConstIterator.
+    const_iterator begin() const
+    {
+        const_iterator it;
+        it.moveTo(head->next[0].load(std::memory_order_acquire));
+        return it;
+    }
+
+    const_iterator lowerBound(const key_type& key) const
+    {
+        const_iterator it;
+        it.moveTo(firstNotBelow(key));
+        return it;
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    MemoryUsage memoryUsage() const // walks the elements while others may change them
+    {
+        MemoryUsage usage{sizeof(*this) + sizeof(Node) + (maxHeight - 1) * sizeof(std::atomic<Node*>), 0};
+        {
+            Epochs::ReadSection section;
+            for(const Node *node = head->next[0].load(std::memory_order_acquire); node != nullptr;
+                node = node->next[0].load(std::memory_order_acquire))
+            {
+                usage.allocated += sizeof(Node) + (node->height - 1) * sizeof(std::atomic<Node*>) + sizeof(value_type);
+                usage.payload += sizeof(value_type);
+            }
+        }
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        usage.allocated += retired.memoryUsage();
+        return usage;
+    }
+};
+
+// Forward only, skip lists have no links back. Elements in the map for the whole iteration are visited
+// once and in order, ones added, replaced or removed meanwhile may or may not be. Every iterator keeps what
+// it can reach from being freed until it is destroyed, and has to stay on the thread that created it.
+template <typename KeyType, typename ValueType>
+class ConcurrentTreeMap<KeyType, ValueType>::ConstIterator
+{
+    friend ConcurrentTreeMap<KeyType, ValueType>;
+public:
+    using reference = typename ConcurrentTreeMap::const_reference;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename ConcurrentTreeMap::value_type;
+    using pointer = const typename ConcurrentTreeMap::value_type*;
+    using difference_type = std::ptrdiff_t;
+private:
+    Epochs::ReadSection section;
+    const Node *position;           // null at the end
+    const value_type *element;      // position's element when the iterator got there
+
+    void pointTo(const Node *node)
+    {
+        position = node;
+        element = node != nullptr ? node->element.load(std::memory_order_acquire) : nullptr;
+    }
+
+    void moveTo(const Node *node) // skips removed nodes and ones still being inserted
+    {
+        while(node != nullptr && (node->marked.load(std::memory_order_acquire)
+                                  || !node->linked.load(std::memory_order_acquire)))
+            node = node->next[0].load(std::memory_order_acquire);
+        pointTo(node);
+    }
+
+public:
+    ConstIterator() : position(nullptr), element(nullptr)
+    {}
+
+    ConstIterator(const ConstIterator& other) : position(other.position), element(other.element)
+    {}
+
+    ConstIterator& operator=(const ConstIterator& other)
+    {
+        position = other.position;
+        element = other.element;
+        return *this;
+    }
+
+    ConstIterator& operator++()
+    {
+        if(position == nullptr)
+            throw std::out_of_range("Attempt to increment end() iterator.");
+
+        moveTo(position->next[0].load(std::memory_order_acquire));
+        return *this;
+    }
+
+    ConstIterator operator++(int)
+    {
+        ConstIterator preObject(*this);
+        operator++();
+        return preObject;
+    }
+
+    reference operator*() const
+    {
+        if(position == nullptr)
+            throw std::out_of_range("Attempt to dereference end() iterator.");
+        return *element;
+    }
+
+    pointer operator->() const
+    {
+        return &this->operator*();
+    }
+
+    bool operator==(const ConstIterator& other) const
+    {
+        return position == other.position;
+    }
+
+    bool operator!=(const ConstIterator& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+}
+
+#endif /* AISDI_MAPS_CONCURRENTTREEMAP_H */
@@ -0,0 +1,225 @@
+#ifndef AISDI_MAPS_EPOCHS_H
+#define AISDI_MAPS_EPOCHS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace aisdi
+{
+
+// Epoch based reclamation for structures read without locks. A reader announces the epoch it started in
+// for as long as its ReadSection lasts. A writer unlinks what it removes, tags it with advance() and frees
+// it once oldestActive() is past the tag, as no reader can reach it any more then. Readers only ever write
+// their own record, which sits on a cache line of its own. One set of epochs is shared by all structures.
+class Epochs
+{
+    struct Reader
+    {
+        std::atomic<std::uint64_t> epoch;   // the announced one, zero outside of read sections
+        std::atomic<bool> claimed;
+        Reader * next;
+        char padding[64];   // keeps records of different threads off each other's cache lines
+
+        Reader() : epoch(0), claimed(true), next(nullptr)
+        {}
+    };
+
+    // The calling thread's record, claimed on its first read section and given back when the thread ends.
+    class ThreadReader
+    {
+        Reader * reader;
+        unsigned depth;     // read sections nest, only the outermost one announces
+
+    public:
+        ThreadReader() : reader(global().claim()), depth(0)
+        {}
+
+        ~ThreadReader()
+        {
+            reader->claimed.store(false, std::memory_order_release);
+        }
+
+        void enter()
+        {
+            if(depth++ != 0)
+                return;
+            reader->epoch.store(global().current.load(), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);    // announced before anything is read
+        }
+
+        void leave()
+        {
+            if(--depth == 0)
+                reader->epoch.store(0, std::memory_order_release);
+        }
+    };
+
+    std::atomic<std::uint64_t> current;
+    std::atomic<Reader*> readers;   // never shrinks, records of finished threads are claimed again
+
+    Epochs() : current(1), readers(nullptr)
+    {}
+
+    ~Epochs() // threads still reading at exit are not supported
+    {
+        for(Reader * reader = readers.load(); reader != nullptr;)
+        {
+            Reader * next = reader->next;
+            delete reader;
+            reader = next;
+        }
+    }
+
+    Reader * claim()
+    {
+        for(Reader * reader = readers.load(std::memory_order_acquire); reader != nullptr; reader = reader->next)
+        {
+            bool claimed = false;
+            if(!reader->claimed.load(std::memory_order_relaxed)
+               && reader->claimed.compare_exchange_strong(claimed, true, std::memory_order_acquire))
+                return reader;
+        }
+
+        Reader * reader = new Reader;
+        reader->next = readers.load(std::memory_order_relaxed);
+        while(!readers.compare_exchange_weak(reader->next, reader, std::memory_order_release,
+                                             std::memory_order_relaxed))
+            ;
+        return reader;
+    }
+
+    static ThreadReader& local()
+    {
+        static thread_local ThreadReader reader;
+        return reader;
+    }
+
+public:
+    Epochs(const Epochs&) = delete;
+    Epochs& operator=(const Epochs&) = delete;
+
+    static Epochs& global()
+    {
+        static Epochs epochs;
+        return epochs;
+    }
+
+    // Everything the calling thread reads while one exists stays allocated. Costs no lock and no shared write.
+    class ReadSection
+    {
+        ThreadReader& reader;
+
+    public:
+        ReadSection() : reader(local())
+        {
+            reader.enter();
+        }
+
+        ~ReadSection()
+        {
+            reader.leave();
+        }
+
+        ReadSection(const ReadSection&) = delete;
+        ReadSection& operator=(const ReadSection&) = delete;
+    };
+
+    // Starts a new epoch. Returns the tag for everything the caller unlinked before the call.
+    std::uint64_t advance()
+    {
+        return current.fetch_add(1);
+    }
+
+    // Everything tagged with an epoch older than the returned one can no longer be reached by any reader.
+    std::uint64_t oldestActive() const
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);    // pairs with the one in ThreadReader::enter
+        std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+        for(Reader * reader = readers.load(std::memory_order_acquire); reader != nullptr; reader = reader->next)
+        {
+            std::uint64_t epoch = reader->epoch.load(std::memory_order_acquire);
+            if(epoch != 0 && epoch < oldest)
+                oldest = epoch;
+        }
+        return oldest;
+    }
+};
+
+// What writers unlinked, freed in batches once no reader can reach it. Not thread safe, writers guard it.
+class RetiredList
+{
+    struct Entry
+    {
+        std::uint64_t epoch;    // zero until the next reclaim() tags it
+        void *pointer;
+        void (*destroy)(void*);
+    };
+
+    enum : std::size_t
+    {
+        reclaimBatch = 64   // an epoch advance and a scan of the readers each
+    };
+
+    std::vector<Entry> entries;
+
+    template <typename Type>
+    static void destroy(void *pointer)
+    {
+        delete static_cast<Type*>(pointer);
+    }
+
+public:
+    RetiredList() = default;
+    RetiredList(const RetiredList&) = delete;
+    RetiredList& operator=(const RetiredList&) = delete;
+
+    ~RetiredList() // nobody may be reading any more
+    {
+        for(auto& entry : entries)
+            entry.destroy(entry.pointer);
+    }
+
+    void reserve(std::size_t count) // makes the next count retire() calls unable to throw
+    {
+        if(entries.capacity() - entries.size() < count)
+            entries.reserve(std::max(2 * entries.capacity(), entries.size() + count));
+    }
+
+    template <typename Type>
+    void retire(Type *pointer) // deleted later, as Type
+    {
+        entries.push_back(Entry{0, const_cast<void*>(static_cast<const void*>(pointer)), &destroy<Type>});
+        if(entries.size() % reclaimBatch == 0)
+            reclaim();
+    }
+
+    void reclaim()
+    {
+        std::uint64_t tag = Epochs::global().advance();
+        for(auto& entry : entries)
+            if(entry.epoch == 0)
+                entry.epoch = tag;
+
+        std::uint64_t oldest = Epochs::global().oldestActive();
+        std::size_t kept = 0;
+        for(auto& entry : entries)
+            if(entry.epoch < oldest)
+                entry.destroy(entry.pointer);
+            else
+                entries[kept++] = entry;
+        entries.resize(kept);
+    }
+
+    std::size_t memoryUsage() const // bytes of the list itself
+    {
+        return entries.capacity() * sizeof(Entry);
+    }
+};
+
+}
+
+#endif /* AISDI_MAPS_EPOCHS_H */
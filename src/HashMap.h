@@ -5,206 +5,972 @@
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <functional>
 #include <iostream>
-#include "LinkedList.h"
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "Hashing.h"
+#include "MemoryUsage.h"
+#include "NodePool.h"
+#include "SwissTable.h"
+#include "RobinHoodTable.h"
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
-class HashMap
+// Separate chaining: every bucket is a pointer to a doubly linked chain of nodes, without sentinels. The table
+// holds the one allocator all nodes come from, so a bucket costs a pointer and an empty one allocates nothing.
+// A bitmap of non-empty buckets lets iteration skip empty ones 64 at a time, so sparse tables iterate fast.
+// The first few elements are kept inline in the table and buckets are only allocated when they no longer fit,
+// so empty and tiny tables allocate nothing. Elements are moved into nodes then (copied where moving may throw),
+// references to them are lost. With CacheHashes every node keeps its key's hash as well, see HashCaching.
+template <typename KeyType, typename ValueType, typename Allocator = PoolAllocator<std::pair<const KeyType, ValueType>>,
+          typename Hasher = Hash<KeyType>, bool CacheHashes = HashCaching<KeyType>::value>
+class ChainedHashTable
 {
 public:
     using key_type = KeyType;
     using mapped_type = ValueType;
     using value_type = std::pair<const key_type, mapped_type>;
     using size_type = std::size_t;
-    using reference = value_type&;
-    using const_reference = const value_type&;
 
-    class ConstIterator;
-    class Iterator;
-    using iterator = Iterator;
-    using const_iterator = ConstIterator;
 private:
-    LinkedList<value_type> * buckets;
-    size_type size;
+    struct HashedElement // what a node holds when hashes are cached
+    {
+        value_type element;
+        size_type hash;     // of the key, before it is masked to a bucket
 
-    inline size_type amountOfBuckets() const
+        template <typename... Args>
+        explicit HashedElement(size_type hash, Args&&... args) : element(std::forward<Args>(args)...), hash(hash)
+        {}
+    };
+
+    using HashesCached = std::integral_constant<bool, CacheHashes>;
+    using Entry = typename std::conditional<CacheHashes, HashedElement, value_type>::type;
+
+    struct Node
     {
-        return 128000;
-    }
+        Entry entry;
+        Node * next;
+        Node * prev;    // nullptr in the first node of a bucket
+
+        template <typename... Args>
+        explicit Node(Args&&... args) : entry(std::forward<Args>(args)...), next(nullptr), prev(nullptr)
+        {}
+    };
 
-    void initBuckets()
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+    using Bucket = Node *;  // first node of the chain, nullptr if the bucket is empty
+
+public:
+    // Bucket index and node inside the bucket, node is nullptr for the end.
+    // While elements are inline, bucket is the element's index and the end is the size.
+    struct Handle
+    {
+        size_type bucket;
+        const Node * node;
+
+        bool operator==(const Handle& other) const
+        {
+            return bucket == other.bucket && node == other.node;
+        }
+
+        bool operator!=(const Handle& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+private:
+    using Slot = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+    enum : size_type
     {
-        buckets = new LinkedList<value_type>[amountOfBuckets()];
+        inlineCapacity = 4,
+        initialBucketCount = 8
+    };
+
+    NodeAllocator allocator;
+    Bucket * buckets;       // nullptr while the elements are inline
+    std::vector<std::uint64_t> occupied;    // bit per bucket, set while the bucket is not empty
+    size_type firstOccupied;                // begin() bucket, the bucket count if all are empty
+    size_type size;
+    size_type bucketCount;
+    float maxLoadFactor;
+    Slot inlineSlots[inlineCapacity];
+
+    inline size_type amountOfBuckets() const
+    {
+        return bucketCount;
     }
 
-    void deallocBuckets()
+    bool isInline() const
     {
-        if(buckets != nullptr)
-            delete [] buckets;
+        return buckets == nullptr;
     }
 
-    size_type getHash(const key_type& key) const
+    static constexpr bool movesInlineElements() // as std::move_if_noexcept does, copies are kept otherwise
     {
-        return std::hash<key_type>{}(key) % amountOfBuckets();
+        return std::is_nothrow_move_constructible<value_type>::value || !std::is_copy_constructible<value_type>::value;
     }
 
-    value_type& getDataForKey(const key_type &key) const
+    value_type& inlineElement(size_type index) const
     {
-        auto hash = getHash(key);
-        for(auto it = buckets[hash].begin(); it != buckets[hash].end(); ++it)
-            if((*it).first == key)
-                return *it;
-        throw std::out_of_range("Attempt to get an element that is not in the map.");
+        return *reinterpret_cast<value_type*>(const_cast<Slot*>(inlineSlots + index));
     }
 
-    bool isKeyInMap(const key_type & key) const
+    template <typename... Args>
+    Node * createNode(Args&&... args)
     {
+        Node * node = NodeAllocatorTraits::allocate(allocator, 1);
         try
         {
-            getDataForKey(key);
-            return true;
+            new (node) Node(std::forward<Args>(args)...);
         }
-        catch(std::out_of_range)
+        catch(...)
         {
-            return false;
+            NodeAllocatorTraits::deallocate(allocator, node, 1);
+            throw;
         }
+        return node;
     }
 
+    void destroyNode(Node * node)
+    {
+        node->~Node();
+        NodeAllocatorTraits::deallocate(allocator, node, 1);
+    }
 
+    void linkFront(size_type bucket, Node * node)
+    {
+        node->prev = nullptr;
+        node->next = buckets[bucket];
+        if(node->next != nullptr)
+            node->next->prev = node;
+        buckets[bucket] = node;
+    }
 
-public:
-    HashMap()
+    void unlink(size_type bucket, Node * node)
     {
-        size = 0;
-        initBuckets();
+        if(node->prev != nullptr)
+            node->prev->next = node->next;
+        else
+            buckets[bucket] = node->next;
+        if(node->next != nullptr)
+            node->next->prev = node->prev;
     }
 
-    ~HashMap()
+    static Bucket * allocBuckets(size_type count) // all empty
     {
-        deallocBuckets();
+        return new Bucket[count]();
     }
 
-    HashMap(std::initializer_list<value_type> list)
-    : HashMap()
+    void initBuckets(size_type count)
     {
-        for(auto element: list)
-            operator[](element.first) = element.second;
+        buckets = allocBuckets(count);
+        bucketCount = count;
+        occupied.assign((count + 63) / 64, 0);
+        firstOccupied = count;
     }
 
-    HashMap(const HashMap& other)
-    : HashMap()
+    void deallocBuckets() // frees the nodes as well
     {
-        size = other.size;
-        for(size_type i = 0; i < amountOfBuckets(); i++)
-            buckets[i] = other.buckets[i];
+        for(size_type bucket = nextOccupied(0); bucket < amountOfBuckets(); bucket = nextOccupied(bucket + 1))
+            for(Node * node = buckets[bucket]; node != nullptr;)
+            {
+                Node * next = node->next;
+                destroyNode(node);
+                node = next;
+            }
+        delete[] buckets;
+        buckets = nullptr;
+        bucketCount = 0;
+        std::vector<std::uint64_t>().swap(occupied);
     }
 
-    HashMap(HashMap&& other)
-    : buckets(other.buckets), size(other.size)
+    void markOccupied(size_type bucket)
     {
-        other.buckets = nullptr;
-        other.size = 0;
+        occupied[bucket / 64] |= std::uint64_t{1} << (bucket % 64);
+        firstOccupied = std::min(firstOccupied, bucket);
     }
 
-    HashMap& operator=(const HashMap& other)
+    void markEmpty(size_type bucket)
     {
-        if(other == *this)
-            return *this;
+        occupied[bucket / 64] &= ~(std::uint64_t{1} << (bucket % 64));
+        if(bucket == firstOccupied)
+            firstOccupied = nextOccupied(bucket + 1);
+    }
+
+    size_type nextOccupied(size_type bucket) const // first non-empty bucket from this one on, bucket count if none
+    {
+        if(bucket >= amountOfBuckets())
+            return amountOfBuckets();
 
+        size_type word = bucket / 64;
+        std::uint64_t bits = occupied[word] & (~std::uint64_t{0} << (bucket % 64));
+        while(bits == 0)
+        {
+            if(++word == occupied.size())
+                return amountOfBuckets();
+            bits = occupied[word];
+        }
+        return word * 64 + static_cast<size_type>(__builtin_ctzll(bits));
+    }
+
+    size_type prevOccupied(size_type bucket) const // last non-empty bucket before this one, there has to be one
+    {
+        size_type word = (bucket - 1) / 64;
+        std::uint64_t bits = occupied[word] & (~std::uint64_t{0} >> (63 - (bucket - 1) % 64));
+        while(bits == 0)
+            bits = occupied[--word];
+        return word * 64 + 63 - static_cast<size_type>(__builtin_clzll(bits));
+    }
+
+    void clear() // leaves the table empty and inline
+    {
+        if(isInline())
+            for(size_type i = 0; i < size; i++)
+                inlineElement(i).~value_type();
+        else
+            deallocBuckets();
+        size = 0;
+    }
+
+    void copyFrom(const ChainedHashTable& other) // this is empty and inline
+    {
+        maxLoadFactor = other.maxLoadFactor;
+        if(other.isInline())
+        {
+            try
+            {
+                for(; size < other.size; size++)
+                    new (inlineSlots + size) value_type(other.inlineElement(size));
+            }
+            catch(...)
+            {
+                clear();    // no destructor runs for a table that throws while being constructed
+                throw;
+            }
+            return;
+        }
+
+        initBuckets(other.amountOfBuckets());
+        try
+        {
+            for(size_type bucket = other.nextOccupied(0); bucket < amountOfBuckets();
+                bucket = other.nextOccupied(bucket + 1))
+            {
+                markOccupied(bucket);
+                Node * copied = nullptr;    // the chains keep their order
+                for(const Node * node = other.buckets[bucket]; node != nullptr; node = node->next)
+                {
+                    Node * copy = createNode(node->entry);
+                    copy->prev = copied;
+                    (copied != nullptr ? copied->next : buckets[bucket]) = copy;
+                    copied = copy;
+                }
+            }
+        }
+        catch(...)
+        {
+            deallocBuckets();
+            throw;
+        }
         size = other.size;
-        for(size_type i = 0; i < amountOfBuckets(); i++)
-            buckets[i] = other.buckets[i];
-        return *this;
     }
 
-    HashMap& operator=(HashMap&& other)
+    void stealFrom(ChainedHashTable& other) // this is empty and inline, so is other afterwards
     {
-        if(other == *this)
-            return *this;
+        maxLoadFactor = other.maxLoadFactor;
+        if(other.isInline())    // elements are moved one by one, the allocators are left alone
+        {
+            for(; size < other.size; size++)
+                new (inlineSlots + size) value_type(std::move(other.inlineElement(size)));
+            other.clear();
+            return;
+        }
 
+        allocator = other.allocator;   // the nodes belong to it
         buckets = other.buckets;
+        bucketCount = other.bucketCount;
+        occupied = std::move(other.occupied);
+        firstOccupied = other.firstOccupied;
         size = other.size;
         other.buckets = nullptr;
+        other.bucketCount = 0;
+        other.occupied.clear();
         other.size = 0;
+    }
 
-        return *this;
+    size_type bucketOf(size_type hash) const
+    {
+        return hash & (amountOfBuckets() - 1);  // the bucket count is a power of two
     }
 
-    bool isEmpty() const
+    static const value_type& elementOf(const HashedElement& entry)
     {
-        return size == 0;
+        return entry.element;
     }
 
-    mapped_type& operator[](const key_type& key)
+    static value_type& elementOf(HashedElement& entry)
     {
-        auto hash = getHash(key);
-        auto position = find(key);
-        if(position == end())
-        {
-            buckets[hash].prepend(std::make_pair(key, mapped_type{}));
-            size++;
-            return buckets[hash][0].second;
-        }
-        else
+        return entry.element;
+    }
+
+    static const value_type& elementOf(const value_type& entry)
+    {
+        return entry;
+    }
+
+    static value_type& elementOf(value_type& entry)
+    {
+        return entry;
+    }
+
+    static size_type hashOf(const HashedElement& entry) // never hashes the key again
+    {
+        return entry.hash;
+    }
+
+    static size_type hashOf(const value_type& entry)
+    {
+        return spreadHash<Hasher>(entry.first);
+    }
+
+    template <typename LookupKey>
+    static bool matches(const HashedElement& entry, size_type hash, const LookupKey& key) // keys of equal hashes only
+    {
+        return entry.hash == hash && entry.element.first == key;
+    }
+
+    template <typename LookupKey>
+    static bool matches(const value_type& entry, size_type, const LookupKey& key)
+    {
+        return entry.first == key;
+    }
+
+    template <typename... Args>
+    Node * createEntry(std::true_type, size_type hash, Args&&... args)
+    {
+        return createNode(hash, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    Node * createEntry(std::false_type, size_type, Args&&... args)
+    {
+        return createNode(std::forward<Args>(args)...);
+    }
+
+    template <typename LookupKey>
+    Handle findInline(const LookupKey& key) const
+    {
+        for(size_type i = 0; i < size; i++)
+            if(inlineElement(i).first == key)
+                return Handle{i, nullptr};
+        return endHandle();
+    }
+
+    template <typename LookupKey>
+    Handle findInBuckets(const LookupKey& key, size_type hash) const // only the key's own bucket is searched
+    {
+        size_type bucket = bucketOf(hash);
+        for(const Node * node = buckets[bucket]; node != nullptr; node = node->next)
+            if(matches(node->entry, hash, key))
+                return Handle{bucket, node};
+        return endHandle();
+    }
+
+    static size_type roundUpToPowerOfTwo(size_type count)
+    {
+        size_type rounded = 1;
+        while(rounded < count)
+            rounded <<= 1;
+        return rounded;
+    }
+
+    size_type bucketsNeededFor(size_type elements) const // smallest bucket count keeping load factor <= max
+    {
+        return static_cast<size_type>(std::ceil(elements / static_cast<double>(maxLoadFactor)));
+    }
+
+    // Most elements the buckets take at the max load factor. In double, as a float has no exact value
+    // for counts above 2^24, the limit could be off by many elements in a big table.
+    size_type growthLimit() const
+    {
+        double limit = amountOfBuckets() * static_cast<double>(maxLoadFactor);
+        return limit < static_cast<double>(std::numeric_limits<size_type>::max())
+               ? static_cast<size_type>(limit) : std::numeric_limits<size_type>::max();
+    }
+
+    void growIfNeeded(size_type elements) // called before inserting, doubles the table when max load factor is crossed
+    {
+        if(isInline())
         {
-            return buckets[position.whichBucket][position.whichElement].second;
+            if(elements > inlineCapacity)
+                rehash(std::max(size_type{initialBucketCount}, bucketsNeededFor(elements)));
         }
+        else if(elements > growthLimit())
+            rehash(std::max(amountOfBuckets() * 2, bucketsNeededFor(elements)));
     }
 
-    const mapped_type& valueOf(const key_type& key) const
+    Handle firstInBucketFrom(size_type whichBucket) const // first element in this or any further bucket
     {
-        if(isEmpty())
-            throw std::out_of_range("Attempt to get a value from an empty map.");
+        whichBucket = nextOccupied(whichBucket);
+        if(whichBucket == amountOfBuckets())
+            return endHandle();
+        return Handle{whichBucket, buckets[whichBucket]};
+    }
+
+public:
+    ChainedHashTable() : buckets(nullptr), firstOccupied(0), size(0), bucketCount(0), maxLoadFactor(1.0f)
+    {}
 
-        return getDataForKey(key).second;
+    ChainedHashTable(const ChainedHashTable& other)
+    : allocator(NodeAllocatorTraits::select_on_container_copy_construction(other.allocator)),
+      buckets(nullptr), firstOccupied(0), size(0), bucketCount(0)
+    {
+        copyFrom(other);
     }
 
-    mapped_type& valueOf(const key_type& key)
+    ChainedHashTable(ChainedHashTable&& other)
+    : buckets(nullptr), firstOccupied(0), size(0), bucketCount(0)
     {
-        if(isEmpty())
-            throw std::out_of_range("Attempt to get a value from an empty map.");
+        stealFrom(other);
+    }
 
-        return getDataForKey(key).second;
+    ~ChainedHashTable()
+    {
+        clear();
     }
 
-    const_iterator find(const key_type& key) const // can be optimised
+    ChainedHashTable& operator=(const ChainedHashTable& other)
     {
-        for(size_type i = 0; i < amountOfBuckets(); i++)
+        if(&other == this)
+            return *this;
+
+        ChainedHashTable copy(other);
+        return *this = std::move(copy);
+    }
+
+    ChainedHashTable& operator=(ChainedHashTable&& other)
+    {
+        if(&other == this)
+            return *this;
+
+        clear();
+        stealFrom(other);
+        return *this;
+    }
+
+    size_type getSize() const
+    {
+        return size;
+    }
+
+    Handle endHandle() const
+    {
+        return Handle{isInline() ? size : amountOfBuckets(), nullptr};
+    }
+
+    Handle first() const
+    {
+        if(isInline())
+            return Handle{0, nullptr};
+        if(firstOccupied == amountOfBuckets())
+            return endHandle();
+        return Handle{firstOccupied, buckets[firstOccupied]};
+    }
+
+    Handle next(Handle position) const
+    {
+        if(isInline())
+            return Handle{position.bucket + 1, nullptr};
+        if(position.node->next != nullptr)
+            return Handle{position.bucket, position.node->next};
+        return firstInBucketFrom(position.bucket + 1);
+    }
+
+    Handle prev(Handle position) const // the end for first(), the table must not be empty
+    {
+        if(isInline())
+            return position.bucket == 0 ? endHandle() : Handle{position.bucket - 1, nullptr};
+        if(position.node != nullptr && position.node->prev != nullptr)
+            return Handle{position.bucket, position.node->prev};
+        if(position.bucket <= firstOccupied)
+            return endHandle();
+
+        size_type bucket = prevOccupied(position.bucket);
+        const Node * last = buckets[bucket];    // chains are short, the load factor keeps them so
+        while(last->next != nullptr)
+            last = last->next;
+        return Handle{bucket, last};
+    }
+
+    const value_type& get(const Handle& position) const
+    {
+        if(isInline())
+            return inlineElement(position.bucket);
+        return elementOf(position.node->entry);
+    }
+
+    value_type& get(const Handle& position)
+    {
+        // ugly cast, yet reduces code duplication.
+        return const_cast<value_type&>(const_cast<const ChainedHashTable*>(this)->get(position));
+    }
+
+    template <typename LookupKey>
+    Handle find(const LookupKey& key) const // inline elements are compared without hashing the key
+    {
+        if(size == 0)
+            return endHandle();
+        if(isInline())
+            return findInline(key);
+        return findInBuckets(key, spreadHash<Hasher>(key));
+    }
+
+    template <typename LookupKey>
+    Handle findHashed(const LookupKey& key, size_type hash) const // hash is spreadHash<Hasher>(key)
+    {
+        if(size == 0)
+            return endHandle();
+        if(isInline())
+            return findInline(key);
+        return findInBuckets(key, hash);
+    }
+
+    // Constructs the value from args if key is missing, key is moved in when passed as an rvalue.
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplace(Key&& key, Args&&... args)
+    {
+        return emplaceIfMissing([&key]() { return spreadHash<Hasher>(key); }, std::forward<Key>(key),
+                                std::forward<Args>(args)...);
+    }
+
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplaceHashed(size_type hash, Key&& key, Args&&... args)
+    {
+        return emplaceIfMissing([hash]() { return hash; }, std::forward<Key>(key), std::forward<Args>(args)...);
+    }
+
+private:
+    // Inline elements are compared without hashing the key, hashKey() is called once buckets need the hash.
+    template <typename HashKey, typename Key, typename... Args>
+    std::pair<Handle, bool> emplaceIfMissing(HashKey hashKey, Key&& key, Args&&... args)
+    {
+        if(isInline())
         {
-            for(size_type counter = 0; counter < buckets[i].getSize(); counter++)
+            auto position = findInline(key);
+            if(position != endHandle())
+                return std::make_pair(position, false);
+
+            if(size < inlineCapacity)
             {
-                if(buckets[i][counter].first == key)
-                    return ConstIterator(this, i, counter);
+                new (inlineSlots + size) value_type(std::piecewise_construct,
+                                                    std::forward_as_tuple(std::forward<Key>(key)),
+                                                    std::forward_as_tuple(std::forward<Args>(args)...));
+                return std::make_pair(Handle{size++, nullptr}, true);
             }
         }
-        return cend();
+
+        size_type hash = hashKey();     // once, for the lookup and for the insertion
+        if(!isInline())
+        {
+            auto position = findInBuckets(key, hash);
+            if(position != endHandle())
+                return std::make_pair(position, false);
+        }
+
+        // built before growing, as leaving the inline slots destroys elements args may refer to
+        Node * node = createEntry(HashesCached(), hash, std::piecewise_construct,
+                                  std::forward_as_tuple(std::forward<Key>(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+        try
+        {
+            growIfNeeded(size + 1);     // may rehash, so the bucket is picked afterwards
+        }
+        catch(...)
+        {
+            destroyNode(node);
+            throw;
+        }
+        size_type bucket = bucketOf(hash);
+        linkFront(bucket, node);
+        markOccupied(bucket);
+        size++;
+        return std::make_pair(Handle{bucket, buckets[bucket]}, true);
     }
 
-    iterator find(const key_type& key) // can be optimised
+public:
+    Handle findOrInsert(const key_type& key) // inserts a value initialized value if key is missing
     {
-        for(size_type i = 0; i < amountOfBuckets(); i++)
+        return tryEmplace(key).first;
+    }
+
+    void erase(const Handle& position)
+    {
+        if(isInline())  // later elements move one slot down
         {
-            for(size_type counter = 0; counter < buckets[i].getSize(); counter++)
+            for(size_type i = position.bucket; i + 1 < size; i++)
             {
-                if(buckets[i][counter].first == key)
-                    return Iterator(this, i, counter);
+                inlineElement(i).~value_type();
+                new (inlineSlots + i) value_type(std::move(inlineElement(i + 1)));
             }
+            inlineElement(size - 1).~value_type();
+            size--;
+            return;
         }
-        return end();
+
+        Node * node = const_cast<Node*>(position.node);
+        unlink(position.bucket, node);
+        destroyNode(node);
+        if(buckets[position.bucket] == nullptr)
+            markEmpty(position.bucket);
+        size--;
     }
 
-    void remove(const key_type& key)
+    size_type bucket_count() const // zero while the elements are inline
     {
-        auto position = find(key);
-        if(position == end())
+        return amountOfBuckets();
+    }
+
+    float load_factor() const
+    {
+        if(amountOfBuckets() == 0)
+            return 0.0f;
+        return static_cast<float>(size) / amountOfBuckets();
+    }
+
+    float max_load_factor() const
+    {
+        return maxLoadFactor;
+    }
+
+    void max_load_factor(float factor) // rehashes immediately if the current load exceeds the new limit
+    {
+        if(!(factor > 0.0f))
+            throw std::invalid_argument("Maximum load factor has to be positive.");
+
+        maxLoadFactor = factor;
+        if(!isInline() && size > growthLimit())
+            rehash(bucketsNeededFor(size));
+    }
+
+    void reserve(size_type elements) // makes room for elements without crossing the max load factor
+    {
+        if(isInline() && elements <= inlineCapacity)
+            return;
+        if(bucketsNeededFor(elements) > amountOfBuckets())
+            rehash(bucketsNeededFor(elements));
+    }
+
+    void rehash(size_type count) // bucket count is rounded up to a power of two, never below what size requires
+    {
+        count = roundUpToPowerOfTwo(std::max(std::max(count, bucketsNeededFor(size)), size_type{1}));
+        if(count == amountOfBuckets())
+            return;
+
+        if(isInline())
+        {
+            initBuckets(count);
+            size_type moved = 0;
+            try
+            {
+                for(; moved < size; moved++)
+                {
+                    size_type hash = hashOf(inlineElement(moved));
+                    size_type bucket = bucketOf(hash);
+                    linkFront(bucket, createEntry(HashesCached(), hash, std::move_if_noexcept(inlineElement(moved))));
+                    markOccupied(bucket);
+                }
+            }
+            catch(...)
+            {
+                if(movesInlineElements())   // values go back, keys are const so they were copied
+                    for(size_type i = 0; i < moved; i++)
+                    {
+                        auto& element = inlineElement(i);
+                        for(Node * node = buckets[bucketOf(hashOf(element))]; node != nullptr; node = node->next)
+                            if(elementOf(node->entry).first == element.first)
+                            {
+                                element.second = std::move(elementOf(node->entry).second);
+                                break;
+                            }
+                    }
+                deallocBuckets();   // back to inline, the elements are still there
+                throw;
+            }
+            for(size_type i = 0; i < size; i++)
+                inlineElement(i).~value_type();
+            return;
+        }
+
+        std::vector<std::uint64_t> oldOccupied((count + 63) / 64, 0);
+        Bucket * oldBuckets = allocBuckets(count);
+        std::swap(oldBuckets, buckets);
+        oldOccupied.swap(occupied);
+        bucketCount = count;
+        firstOccupied = count;
+
+        // nodes of the non-empty old buckets are relinked, values are neither copied nor moved
+        for(size_type word = 0; word < oldOccupied.size(); word++)
+            for(std::uint64_t bits = oldOccupied[word]; bits != 0; bits &= bits - 1)
+            {
+                for(Node * node = oldBuckets[word * 64 + static_cast<size_type>(__builtin_ctzll(bits))];
+                    node != nullptr;)
+                {
+                    Node * next = node->next;
+                    size_type bucket = bucketOf(hashOf(node->entry));   // cached hashes are not computed again
+                    linkFront(bucket, node);
+                    markOccupied(bucket);
+                    node = next;
+                }
+            }
+
+        delete[] oldBuckets;
+    }
+
+    MemoryUsage memoryUsage() const
+    {
+        return MemoryUsage{sizeof(*this) + occupied.capacity() * sizeof(std::uint64_t)
+                           + amountOfBuckets() * sizeof(Bucket) + (isInline() ? 0 : size * sizeof(Node)),
+                           size * sizeof(value_type)};
+    }
+};
+
+struct ChainedBuckets // default HashMap policy
+{
+    template <typename KeyType, typename ValueType, typename Allocator, typename Hasher>
+    using Table = ChainedHashTable<KeyType, ValueType, Allocator, Hasher>;
+};
+
+struct ChainedBucketsWithHashes // HashMap policy, chained buckets caching the hashes of any key type
+{
+    template <typename KeyType, typename ValueType, typename Allocator, typename Hasher>
+    using Table = ChainedHashTable<KeyType, ValueType, Allocator, Hasher, true>;
+};
+
+// Allocator is used for the nodes of policies allocating one per element, open addressing ignores it.
+// Hasher is default constructed wherever a key is hashed, so it has to be stateless. Its results are mixed
+// unless it declares is_avalanching, see Hashing.h, which has fast ones for integers and strings.
+template <typename KeyType, typename ValueType, typename TablePolicy = ChainedBuckets,
+          typename Allocator = PoolAllocator<std::pair<const KeyType, ValueType>>, typename Hasher = Hash<KeyType>>
+class HashMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+    using hasher = Hasher;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    class ConstIterator;
+    class Iterator;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+private:
+    using Table = typename TablePolicy::template Table<key_type, mapped_type, Allocator, Hasher>;
+    using Handle = typename Table::Handle;
+
+    Table table;
+
+    template <typename LookupKey>
+    const mapped_type& lookUp(const LookupKey& key) const
+    {
+        if(isEmpty())
+            throw std::out_of_range("Attempt to get a value from an empty map.");
+
+        auto position = table.find(key);
+        if(position == table.endHandle())
+            throw std::out_of_range("Attempt to get an element that is not in the map.");
+        return table.get(position).second;
+    }
+
+    template <typename LookupKey>
+    void removeKey(const LookupKey& key)
+    {
+        auto position = table.find(key);
+        if(position == table.endHandle())
             throw std::out_of_range("Attempt to remove from an empty map.");
 
-        size--;
-        buckets[position.whichBucket].erase(position.whichElement);
+        table.erase(position);
+    }
+
+public:
+    HashMap()
+    {}
+
+    ~HashMap()
+    {}
+
+    HashMap(std::initializer_list<value_type> list)
+    : HashMap()
+    {
+        reserve(list.size());
+        for(const auto& element : list)  // a repeated key takes the last value
+            insert_or_assign(element.first, element.second);
+    }
+
+    HashMap(const HashMap& other)
+    : table(other.table)
+    {}
+
+    HashMap(HashMap&& other)
+    : table(std::move(other.table))
+    {}
+
+    HashMap& operator=(const HashMap& other)
+    {
+        table = other.table;
+        return *this;
+    }
+
+    HashMap& operator=(HashMap&& other)
+    {
+        table = std::move(other.table);
+        return *this;
+    }
+
+    bool isEmpty() const
+    {
+        return table.getSize() == 0;
+    }
+
+    mapped_type& operator[](const key_type& key)
+    {
+        return table.get(table.findOrInsert(key)).second;
+    }
+
+    mapped_type& operator[](key_type&& key)
+    {
+        return table.get(table.tryEmplace(std::move(key)).first).second;
+    }
+
+    // Adds an element with the value constructed from args unless key is already present, then args are left alone.
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        auto result = table.tryEmplace(key, std::forward<Args>(args)...);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        auto result = table.tryEmplace(std::move(key), std::forward<Args>(args)...);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    // Adds an element constructed from args unless its key is already present. The element is built before
+    // the lookup, as its key is not known earlier, so prefer try_emplace when the key is at hand.
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type element(std::forward<Args>(args)...);
+        return try_emplace(element.first, std::move(element.second));
+    }
+
+    template <typename Value>
+    std::pair<iterator, bool> insert_or_assign(const key_type& key, Value&& value)
+    {
+        auto result = table.tryEmplace(key, std::forward<Value>(value));
+        if(!result.second)
+            table.get(result.first).second = std::forward<Value>(value);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    template <typename Value>
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, Value&& value)
+    {
+        auto result = table.tryEmplace(std::move(key), std::forward<Value>(value));
+        if(!result.second)
+            table.get(result.first).second = std::forward<Value>(value);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    const mapped_type& valueOf(const key_type& key) const
+    {
+        return lookUp(key);
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    const mapped_type& valueOf(const LookupKey& key) const // e.g. by a StringView in a map keyed by std::string
+    {
+        return lookUp(key);
+    }
+
+    mapped_type& valueOf(const key_type& key)
+    {
+        // ugly cast, yet reduces code duplication.
+        return const_cast<mapped_type&>(lookUp(key));
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    mapped_type& valueOf(const LookupKey& key)
+    {
+        return const_cast<mapped_type&>(lookUp(key));
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        return ConstIterator(this, table.find(key));
+    }
+
+    iterator find(const key_type& key)
+    {
+        return Iterator(this, table.find(key));
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    const_iterator find(const LookupKey& key) const
+    {
+        return ConstIterator(this, table.find(key));
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    iterator find(const LookupKey& key)
+    {
+        return Iterator(this, table.find(key));
+    }
+
+    // For callers that hash the key themselves anyway, e.g. to pick one of several maps.
+    // hash has to be spreadHash<Hasher>(key), the map would not find the key again with any other one.
+    const_iterator findHashed(const key_type& key, size_type hash) const
+    {
+        return ConstIterator(this, table.findHashed(key, hash));
+    }
+
+    iterator findHashed(const key_type& key, size_type hash)
+    {
+        return Iterator(this, table.findHashed(key, hash));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> tryEmplaceHashed(size_type hash, const key_type& key, Args&&... args)
+    {
+        auto result = table.tryEmplaceHashed(hash, key, std::forward<Args>(args)...);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    void remove(const key_type& key)
+    {
+        removeKey(key);
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    void remove(const LookupKey& key)
+    {
+        removeKey(key);
     }
 
     void remove(const const_iterator& it)
@@ -212,21 +978,67 @@ public:
         if(it == cend())
             throw std::out_of_range("Attempt to remove from an empty map.");
 
-        size--;
-        buckets[it.whichBucket].erase(it.whichElement);
+        table.erase(it.position);
     }
 
     size_type getSize() const
     {
-        return size;
+        return table.getSize();
+    }
+
+    size_type bucket_count() const
+    {
+        return table.bucket_count();
+    }
+
+    float load_factor() const
+    {
+        return table.load_factor();
+    }
+
+    float max_load_factor() const
+    {
+        return table.max_load_factor();
+    }
+
+    void max_load_factor(float factor)
+    {
+        table.max_load_factor(factor);
+    }
+
+    void reserve(size_type elements)
+    {
+        table.reserve(elements);
+    }
+
+    void rehash(size_type count)
+    {
+        table.rehash(count);
+    }
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage = table.memoryUsage();
+        usage.allocated += sizeof(*this) - sizeof(table);
+        return usage;
+    }
+
+    size_type maxProbeLength() const // only for policies tracking probe lengths, e.g. RobinHood
+    {
+        return table.maxProbeLength();
+    }
+
+    double meanProbeLength() const
+    {
+        return table.meanProbeLength();
     }
 
     bool operator==(const HashMap& other) const
     {
-        if(size != other.size)
+        if(getSize() != other.getSize())
             return false;
 
-        for(auto element : other)
+        for(const auto& element : other)
         {
             auto foundEl = find(element.first);
             if(foundEl == cend() || foundEl->second != element.second)
@@ -253,18 +1065,12 @@ public:
 
     const_iterator cbegin() const
     {
-        for(size_type whichBucket = 0; whichBucket < amountOfBuckets(); whichBucket++)
-        {
-            if(buckets[whichBucket].getSize() > 0)
-                return ConstIterator(this, whichBucket, 0);
-        }
-        return cend();
-
+        return ConstIterator(this, table.first());
     }
 
     const_iterator cend() const
     {
-        return ConstIterator(this, amountOfBuckets(), 0);
+        return ConstIterator(this, table.endHandle());
     }
 
     const_iterator begin() const
@@ -278,24 +1084,23 @@ public:
     }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename TablePolicy, typename Allocator, typename Hasher>
+class HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher>::ConstIterator
 {
-    friend HashMap<KeyType, ValueType>;
+    friend HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher>;
 public:
     using reference = typename HashMap::const_reference;
     using iterator_category = std::bidirectional_iterator_tag;
     using value_type = typename HashMap::value_type;
     using pointer = const typename HashMap::value_type*;
-    using size_type = HashMap::size_type;
+    using size_type = typename HashMap::size_type;
 protected:
-    HashMap<KeyType, ValueType> * whichMap;
-    size_type whichBucket;
-    size_type whichElement;
-    ConstIterator(const HashMap<KeyType, ValueType> * whichM, size_type whichB, size_type whichE)
-    : whichBucket(whichB), whichElement(whichE)
+    HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher> * whichMap;
+    Handle position;
+    ConstIterator(const HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher> * whichM, Handle whichP)
+    : position(whichP)
     {
-        whichMap = const_cast<HashMap<KeyType, ValueType> *>(whichM);
+        whichMap = const_cast<HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher> *>(whichM);
     }
 
 
@@ -306,33 +1111,17 @@ public:
     ConstIterator(const ConstIterator& other)
     {
         whichMap = other.whichMap;
-        whichBucket = other.whichBucket;
-        whichElement = other.whichElement;
+        position = other.position;
     }
 
+    ConstIterator& operator=(const ConstIterator& other) = default;
+
     ConstIterator& operator++()
     {
-        if(*this == whichMap->cend())
+        if(position == whichMap->table.endHandle())
             throw std::out_of_range("Attempt to increment end() iterator.");
 
-        if(whichElement + 1 < whichMap->buckets[whichBucket].getSize())
-        {
-            whichElement++;
-            return *this;
-        }
-
-        for(size_type i = whichBucket + 1; i < whichMap->amountOfBuckets(); i++)
-        {
-            if(whichMap->buckets[i].getSize() > 0)
-            {
-                whichBucket = i;
-                whichElement = 0;
-                return *this;
-            }
-        }
-
-        whichBucket = whichMap->amountOfBuckets(); // end iterator
-        whichElement = 0;
+        position = whichMap->table.next(position);
         return *this;
     }
 
@@ -345,24 +1134,14 @@ public:
 
     ConstIterator& operator--()
     {
-        if(*this == whichMap->cbegin())
+        if(whichMap->isEmpty())
+            throw std::out_of_range("Attempt to decrement begin() iterator in an empty map.");
+        auto previous = whichMap->table.prev(position);
+        if(previous == whichMap->table.endHandle())
             throw std::out_of_range("Attempt to decrement begin() iterator.");
 
-        if(whichElement > 0)
-        {
-            whichElement--;
-            return *this;
-        }
-
-        for(size_type i = whichBucket - 1; true; i--)
-        {
-            if(whichMap->buckets[i].getSize() > 0)
-            {
-                whichBucket = i;
-                whichElement = whichMap->buckets[i].getSize() - 1;
-                return *this;
-            }
-        }
+        position = previous;
+        return *this;
     }
 
     ConstIterator operator--(int)
@@ -372,14 +1151,16 @@ public:
         return preObject;
     }
 
-    reference operator*() const
+    reference operator*() const // O(1), the handle points at the element itself
     {
-        if(whichMap->isEmpty())
-            throw std::out_of_range("Attempt to dereference end() iterator in an empty map.");
-        if(whichMap->begin() == whichMap->cend())
+        if(position == whichMap->table.endHandle())
+        {
+            if(whichMap->isEmpty())
+                throw std::out_of_range("Attempt to dereference end() iterator in an empty map.");
             throw std::out_of_range("Attempt to dereference end() iterator.");
+        }
 
-        return whichMap->buckets[whichBucket][whichElement];
+        return whichMap->table.get(position);
     }
 
     pointer operator->() const
@@ -389,7 +1170,7 @@ public:
 
     bool operator==(const ConstIterator& other) const
     {
-        return whichMap == other.whichMap && whichBucket == other.whichBucket && whichElement == other.whichElement;
+        return whichMap == other.whichMap && position == other.position;
     }
 
     bool operator!=(const ConstIterator& other) const
@@ -398,16 +1179,16 @@ public:
     }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::Iterator : public HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename TablePolicy, typename Allocator, typename Hasher>
+class HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher>::Iterator : public HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher>::ConstIterator
 {
-    friend HashMap<KeyType, ValueType>;
+    friend HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher>;
 public:
     using reference = typename HashMap::reference;
     using pointer = typename HashMap::value_type*;
 protected:
-    Iterator(HashMap<KeyType, ValueType> * whichM, size_type whichB, size_type whichE)
-    : ConstIterator(whichM, whichB, whichE)
+    Iterator(HashMap<KeyType, ValueType, TablePolicy, Allocator, Hasher> * whichM, Handle whichP)
+    : ConstIterator(whichM, whichP)
     {
 
     }
@@ -0,0 +1,190 @@
+#ifndef AISDI_MAPS_HASHING_H
+#define AISDI_MAPS_HASHING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include "Lookup.h"
+
+namespace aisdi
+{
+
+// Spreads the bits of a std::hash result over the whole word.
+// The tables take bucket indices and fingerprints from different bits,
+// which the identity std::hash of integers would leave mostly zero.
+inline std::size_t mixHashBits(std::uint64_t hash) // MurmurHash3 finalizer
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return static_cast<std::size_t>(hash);
+}
+
+// 64 x 64 bit multiplication folded to 64 bits, the high half xored into the low one (wyhash's mum)
+inline std::uint64_t foldedMultiply(std::uint64_t a, std::uint64_t b)
+{
+    __extension__ typedef unsigned __int128 Wide;
+    Wide product = static_cast<Wide>(a) * b;
+    return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+}
+
+// Hashers declaring is_avalanching already spread their result over all bits, the tables use it as it is.
+// Others, e.g. std::hash, are passed through mixHashBits first.
+template <typename Hasher, typename = void>
+struct IsAvalanching : std::false_type
+{};
+
+template <typename Hasher>
+struct IsAvalanching<Hasher, typename std::conditional<true, void, typename Hasher::is_avalanching>::type>
+: std::true_type
+{};
+
+template <typename Hasher, typename LookupKey>
+std::size_t spreadHash(const LookupKey& key, std::true_type)
+{
+    return Hasher()(key);
+}
+
+template <typename Hasher, typename LookupKey>
+std::size_t spreadHash(const LookupKey& key, std::false_type)
+{
+    return mixHashBits(Hasher()(key));
+}
+
+// What the tables pick buckets and fingerprints from, hashers are default constructed for every call.
+template <typename Hasher, typename LookupKey>
+std::size_t spreadHash(const LookupKey& key)
+{
+    return spreadHash<Hasher>(key, IsAvalanching<Hasher>());
+}
+
+// Integers and enums, a single multiplication by 2^64 / golden ratio, folded.
+// std::hash of an integer is the integer, which puts consecutive or strided ids in neighbouring buckets.
+struct IntegerHash
+{
+    using is_avalanching = void;
+
+    template <typename Integer>
+    std::size_t operator()(Integer key) const
+    {
+        return static_cast<std::size_t>(foldedMultiply(static_cast<std::uint64_t>(key), 0x9E3779B97F4A7C15ull));
+    }
+};
+
+// Strings and any StringView-convertible text, a wyhash (final version 4, by Wang Yi) variant: 16 bytes
+// of input per folded multiplication, 48 per three of them for long strings. Reads in native byte order,
+// so results differ between little and big endian machines, as they do for std::hash.
+struct StringHash
+{
+    using is_avalanching = void;
+
+private:
+    static std::uint64_t read8(const unsigned char *bytes)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    static std::uint64_t read4(const unsigned char *bytes)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    static std::uint64_t read3(const unsigned char *bytes, std::size_t length) // 1 to 3 bytes
+    {
+        return (std::uint64_t{bytes[0]} << 16) | (std::uint64_t{bytes[length >> 1]} << 8) | bytes[length - 1];
+    }
+
+public:
+    std::size_t operator()(StringView text) const
+    {
+        const std::uint64_t secret[4] = { 0xA0761D6478BD642Full, 0xE7037ED1A0B428DBull,
+                                          0x8EBC6AF09C88C6E3ull, 0x589965CC75374CC3ull };
+        const unsigned char *bytes = reinterpret_cast<const unsigned char*>(text.data());
+        std::size_t length = text.size();
+        std::uint64_t seed = foldedMultiply(secret[0], secret[1]);
+        std::uint64_t a, b;
+        if(length <= 16)
+        {
+            if(length >= 4)
+            {
+                std::size_t middle = (length >> 3) << 2;
+                a = (read4(bytes) << 32) | read4(bytes + middle);
+                b = (read4(bytes + length - 4) << 32) | read4(bytes + length - 4 - middle);
+            }
+            else if(length > 0)
+            {
+                a = read3(bytes, length);
+                b = 0;
+            }
+            else
+                a = b = 0;
+        }
+        else
+        {
+            std::size_t left = length;
+            if(left > 48)
+            {
+                std::uint64_t second = seed, third = seed;
+                do
+                {
+                    seed = foldedMultiply(read8(bytes) ^ secret[1], read8(bytes + 8) ^ seed);
+                    second = foldedMultiply(read8(bytes + 16) ^ secret[2], read8(bytes + 24) ^ second);
+                    third = foldedMultiply(read8(bytes + 32) ^ secret[3], read8(bytes + 40) ^ third);
+                    bytes += 48;
+                    left -= 48;
+                }
+                while(left > 48);
+                seed ^= second ^ third;
+            }
+            while(left > 16)
+            {
+                seed = foldedMultiply(read8(bytes) ^ secret[1], read8(bytes + 8) ^ seed);
+                bytes += 16;
+                left -= 16;
+            }
+            a = read8(bytes + left - 16);   // the last 16 bytes, overlapping ones already hashed
+            b = read8(bytes + left - 8);
+        }
+
+        __extension__ typedef unsigned __int128 Wide;
+        Wide product = static_cast<Wide>(a ^ secret[1]) * (b ^ seed);
+        a = static_cast<std::uint64_t>(product);
+        b = static_cast<std::uint64_t>(product >> 64);
+        return static_cast<std::size_t>(foldedMultiply(a ^ secret[0] ^ length, b ^ secret[1]));
+    }
+};
+
+// Hash the tables use unless given another: IntegerHash for integers and enums, std::hash for the rest.
+template <typename Key>
+struct Hash : std::conditional<std::is_integral<Key>::value || std::is_enum<Key>::value, IntegerHash,
+                               std::hash<Key>>::type
+{};
+
+// Every text that equals a key hashes as the key does, so lookups need no std::string.
+template <>
+struct Hash<std::string> : StringHash
+{};
+
+// Whether the chained HashMap caches the hash of every key in its node. Walking a chain then compares hashes
+// before keys and growing the table never hashes a key again, for a word per element. On for strings, where
+// hashing and comparing cost more than that, specialize it for other costly keys.
+template <typename Key>
+struct HashCaching : std::false_type
+{};
+
+template <>
+struct HashCaching<std::string> : std::true_type
+{};
+
+}
+
+#endif /* AISDI_MAPS_HASHING_H */
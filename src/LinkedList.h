@@ -3,12 +3,17 @@
 
 #include <cstddef>
 #include <initializer_list>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <utility>
+#include "MemoryUsage.h"
+#include "NodePool.h"
 
 namespace aisdi
 {
 
-template <typename Type>
+template <typename Type, typename Allocator = PoolAllocator<Type>>
 class LinkedList
 {
 public:
@@ -19,6 +24,7 @@ public:
     using reference = Type&;
     using const_pointer = const Type*;
     using const_reference = const Type&;
+    using allocator_type = Allocator;
 
     class ConstIterator;
     class Iterator;
@@ -29,11 +35,8 @@ private:
     class Node
     {
     public:
-        Node() : item(value_type{}), next(nullptr), prev(nullptr)
-        {
-
-        }
-        Node(const value_type &item) :item(item), next(nullptr), prev(nullptr)
+        template <typename... Args>
+        explicit Node(Args&&... args) : item(std::forward<Args>(args)...), next(nullptr), prev(nullptr)
         {
 
         }
@@ -44,12 +47,45 @@ private:
     } * first, * last; // for head and tail (sentinel)
     size_type count;
 
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+    NodeAllocator allocator;
+
+    template <typename... Args>
+    Node * createNode(Args&&... args)
+    {
+        Node * node = NodeAllocatorTraits::allocate(allocator, 1);
+        try
+        {
+            new (node) Node(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            NodeAllocatorTraits::deallocate(allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroyNode(Node * node)
+    {
+        if(node == nullptr) // moved-from list
+            return;
+        node->~Node();
+        NodeAllocatorTraits::deallocate(allocator, node, 1);
+    }
+
 public:
 
     LinkedList()
+    : LinkedList(Allocator())
+    {}
+
+    explicit LinkedList(const Allocator& nodeAllocator)
+    : allocator(nodeAllocator)
     {
         count = 0;
-        Node * newNode = new Node();
+        Node * newNode = createNode();
         first = newNode;
         last = newNode;
     }
@@ -57,7 +93,7 @@ public:
     LinkedList(std::initializer_list<Type> l)
     {
         count = 0;
-        Node * newNode = new Node(); // sentinel
+        Node * newNode = createNode(); // sentinel
         first = newNode;
         last = newNode;
         if(l.size() != 0)
@@ -66,9 +102,10 @@ public:
     }
 
     LinkedList(const LinkedList& other)
+    : allocator(NodeAllocatorTraits::select_on_container_copy_construction(other.allocator))
     {
         count=0;
-        Node * newNode = new Node();
+        Node * newNode = createNode();
         first = newNode;
         last = newNode;
         for(auto i = other.cbegin(); i != other.cend(); ++i)
@@ -76,6 +113,7 @@ public:
     }
 
     LinkedList(LinkedList&& other)
+    : allocator(other.allocator) // nodes stay where other's allocator put them
     {
         first = other.first;
         last = other.last;
@@ -91,9 +129,9 @@ public:
         while(i != first)
         {
             i = i->prev;
-            delete i->next;
+            destroyNode(i->next);
         }
-        delete i;
+        destroyNode(i);
     }
 
     LinkedList& operator=(const LinkedList& other)
@@ -114,7 +152,8 @@ public:
             return *this;
 
         erase(begin(),end());
-        delete last;
+        destroyNode(last);
+        allocator = other.allocator;
         first = other.first;
         last = other.last;
         count = other.count;
@@ -135,9 +174,21 @@ public:
         return count;
     }
 
+    MemoryUsage memoryUsage() const // a node per element and the sentinel, unless moved from
+    {
+        size_type nodes = last == nullptr ? 0 : count + 1;
+        return MemoryUsage{sizeof(*this) + nodes * sizeof(Node), count * sizeof(value_type)};
+    }
+
     void append(const Type& item)
     {
-        Node * ptr = new Node(item);
+        emplaceBack(item);
+    }
+
+    template <typename... Args>
+    void emplaceBack(Args&&... args) // constructs the item in its node from args
+    {
+        Node * ptr = createNode(std::forward<Args>(args)...);
         if(count == 0)
         {
 
@@ -163,7 +214,13 @@ public:
 
     void prepend(const Type& item)
     {
-        Node * ptr = new Node(item); // node to be added
+        emplaceFront(item);
+    }
+
+    template <typename... Args>
+    void emplaceFront(Args&&... args) // constructs the item in its node from args
+    {
+        Node * ptr = createNode(std::forward<Args>(args)...); // node to be added
         if(count == 0)
         {
 
@@ -193,7 +250,7 @@ public:
             prepend(item);
         else
         {
-            auto inserted = new Node(item); // node to be added
+            auto inserted = createNode(item); // node to be added
             insertPosition.getNode() -> prev -> next = inserted;
             inserted -> prev = insertPosition.getNode() -> prev;
             insertPosition.getNode() -> prev = inserted;
@@ -236,15 +293,16 @@ public:
         {
             if(getSize() == 1)
             {
-                delete first;
+                destroyNode(first);
                 first = last;
+                last->prev = nullptr;
             }
             else if(getSize() > 1)
             {
                 auto toBeErased = first;
                 first = first->next;
                 first->prev = nullptr;
-                delete toBeErased;
+                destroyNode(toBeErased);
             }
         }
         else if(position == (cend()-1) )
@@ -253,7 +311,7 @@ public:
             auto ptr = last->prev;
             last->prev = last->prev->prev;
             last->prev->next = last;
-            delete ptr;
+            destroyNode(ptr);
 
         }
         else
@@ -261,7 +319,7 @@ public:
             Node * erased = position.getNode();
             erased->prev->next = erased->next;
             erased->next->prev = erased->prev;
-            delete erased;
+            destroyNode(erased);
         }
         --count;
     }
@@ -317,10 +375,10 @@ public:
 
 };
 
-template <typename Type>
-class LinkedList<Type>::ConstIterator
+template <typename Type, typename Allocator>
+class LinkedList<Type, Allocator>::ConstIterator
 {
-    friend LinkedList<Type>;
+    friend LinkedList<Type, Allocator>;
 public:
     using iterator_category = std::bidirectional_iterator_tag;
     using value_type = typename LinkedList::value_type;
@@ -339,7 +397,7 @@ protected:
 
     }
 public:
-    explicit ConstIterator()
+    explicit ConstIterator() : current(nullptr)
     {}
 
     reference operator*() const
@@ -415,10 +473,10 @@ public:
     }
 };
 
-template <typename Type>
-class LinkedList<Type>::Iterator : public LinkedList<Type>::ConstIterator
+template <typename Type, typename Allocator>
+class LinkedList<Type, Allocator>::Iterator : public LinkedList<Type, Allocator>::ConstIterator
 {
-    friend LinkedList<Type>;
+    friend LinkedList<Type, Allocator>;
 public:
     using pointer = typename LinkedList::pointer;
     using reference = typename LinkedList::reference;
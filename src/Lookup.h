@@ -0,0 +1,88 @@
+#ifndef AISDI_MAPS_LOOKUP_H
+#define AISDI_MAPS_LOOKUP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace aisdi
+{
+
+// Characters owned by someone else, e.g. a network buffer, as C++11 has no std::string_view.
+// Maps keyed by std::string can be searched with it without building a temporary std::string.
+class StringView
+{
+    const char *first;
+    std::size_t length;
+
+public:
+    StringView(const char *text) : first(text), length(std::strlen(text))
+    {}
+
+    StringView(const char *text, std::size_t length) : first(text), length(length)
+    {}
+
+    StringView(const std::string& text) : first(text.data()), length(text.size())
+    {}
+
+    const char * data() const
+    {
+        return first;
+    }
+
+    std::size_t size() const
+    {
+        return length;
+    }
+
+    int compare(StringView other) const // as std::string::compare does
+    {
+        int result = std::memcmp(first, other.first, std::min(length, other.length));
+        if(result != 0)
+            return result;
+        return length < other.length ? -1 : length > other.length ? 1 : 0;
+    }
+
+    explicit operator std::string() const
+    {
+        return std::string(first, length);
+    }
+};
+
+inline bool operator==(StringView left, StringView right)
+{
+    return left.size() == right.size() && left.compare(right) == 0;
+}
+
+inline bool operator!=(StringView left, StringView right)
+{
+    return !(left == right);
+}
+
+inline bool operator<(StringView left, StringView right)
+{
+    return left.compare(right) < 0;
+}
+
+// Whether maps keyed by Key can be searched by LookupKey without converting it to the key first.
+// A lookup type has to compare with the key through == (and < for TreeMap) both ways, and Hash<Key>
+// from Hashing.h has to hash it as it hashes an equal key.
+template <typename Key, typename LookupKey>
+struct TransparentKey : std::false_type
+{};
+
+template <typename LookupKey> // by StringView, const char*, string literals and whatever converts to StringView
+struct TransparentKey<std::string, LookupKey> : std::is_convertible<const LookupKey&, StringView>
+{};
+
+// Enables the lookup overloads taking LookupKey, the ones taking the key itself are plain functions,
+// so other types, e.g. an int for a std::string key, fail at the call and not deep inside the map.
+template <typename Key, typename LookupKey>
+using EnableIfLookupKey = typename std::enable_if<TransparentKey<Key, LookupKey>::value
+                                                  && !std::is_same<Key, LookupKey>::value>::type;
+
+}
+
+#endif /* AISDI_MAPS_LOOKUP_H */
@@ -0,0 +1,32 @@
+#ifndef AISDI_MAPS_MEMORYUSAGE_H
+#define AISDI_MAPS_MEMORYUSAGE_H
+
+#include <cstddef>
+#include <limits>
+
+namespace aisdi
+{
+
+// What a container costs, shallow: memory the elements own themselves, e.g. string buffers, is not counted,
+// neither is slack the allocator keeps, e.g. free blocks of a pool.
+struct MemoryUsage
+{
+    std::size_t allocated;  // bytes of the container object and of everything it requested from allocators
+    std::size_t payload;    // bytes of the stored elements, sizeof(value_type) each
+
+    std::size_t overhead() const
+    {
+        return allocated - payload;
+    }
+
+    double overheadRatio() const // overhead bytes per payload byte, infinite for an empty container
+    {
+        if(payload == 0)
+            return std::numeric_limits<double>::infinity();
+        return static_cast<double>(overhead()) / payload;
+    }
+};
+
+}
+
+#endif /* AISDI_MAPS_MEMORYUSAGE_H */
@@ -0,0 +1,229 @@
+#ifndef AISDI_MAPS_NODEPOOL_H
+#define AISDI_MAPS_NODEPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace aisdi
+{
+
+// Hands out blocks of one size carved from slabs, freed blocks are recycled through a free list.
+// Slabs double in size up to a limit and are only released, all at once, when the pool is destroyed.
+// Not thread safe.
+class NodePool
+{
+public:
+    using size_type = std::size_t;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock * next;
+    };
+
+    struct Slab
+    {
+        Slab * next;
+    };
+
+    enum : size_type
+    {
+        alignment = alignof(std::max_align_t),  // what ::operator new guarantees for the slab
+        slabHeaderSize = (sizeof(Slab) + alignment - 1) / alignment * alignment,
+        firstSlabBlocks = 16,
+        maxSlabBlocks = 4096
+    };
+
+    size_type blockSize;
+    FreeBlock * freeList;
+    Slab * slabs;
+    char * unused;          // blocks of the newest slab that were never handed out
+    char * unusedEnd;
+    size_type nextSlabBlocks;
+
+    void addSlab()
+    {
+        Slab *slab = static_cast<Slab*>(::operator new(slabHeaderSize + nextSlabBlocks * blockSize));
+        slab->next = slabs;
+        slabs = slab;
+        unused = reinterpret_cast<char*>(slab) + slabHeaderSize;
+        unusedEnd = unused + nextSlabBlocks * blockSize;
+        if(nextSlabBlocks < maxSlabBlocks)
+            nextSlabBlocks *= 2;
+    }
+
+public:
+    explicit NodePool(size_type size)
+    : blockSize(sizeFor(size)), freeList(nullptr), slabs(nullptr), unused(nullptr), unusedEnd(nullptr),
+      nextSlabBlocks(firstSlabBlocks)
+    {}
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool()
+    {
+        while(slabs != nullptr)
+        {
+            Slab *next = slabs->next;
+            ::operator delete(slabs);
+            slabs = next;
+        }
+    }
+
+    static size_type sizeFor(size_type size) // block size serving objects of the given size
+    {
+        if(size < sizeof(FreeBlock))
+            size = sizeof(FreeBlock);
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    size_type getBlockSize() const
+    {
+        return blockSize;
+    }
+
+    void * allocate()
+    {
+        if(freeList != nullptr)
+        {
+            FreeBlock *block = freeList;
+            freeList = block->next;
+            return block;
+        }
+
+        if(unused == unusedEnd)
+            addSlab();
+        void *block = unused;
+        unused += blockSize;
+        return block;
+    }
+
+    void deallocate(void *block)
+    {
+        FreeBlock *freed = static_cast<FreeBlock*>(block);
+        freed->next = freeList;
+        freeList = freed;
+    }
+};
+
+// Pools of one container, one per block size, so node types of different sizes can share it.
+class NodeArena
+{
+public:
+    using size_type = std::size_t;
+
+private:
+    std::vector<std::unique_ptr<NodePool>> pools;
+
+public:
+    NodePool& poolFor(size_type size)
+    {
+        size_type blockSize = NodePool::sizeFor(size);
+        for(auto& pool : pools)
+            if(pool->getBlockSize() == blockSize)
+                return *pool;
+
+        pools.emplace_back(new NodePool(blockSize));
+        return *pools.back();
+    }
+};
+
+// Allocator drawing single objects from a NodeArena, bigger requests go to ::operator new.
+// Copies and rebound copies share the arena, which lives as long as any of them does.
+// A container copy gets an arena of its own, so independent containers never share slabs.
+// The arena is only created when the allocator is first used, copied or compared, so constructing one is free.
+template <typename Type>
+class PoolAllocator
+{
+    template <typename Other>
+    friend class PoolAllocator;
+
+public:
+    using value_type = Type;
+    using size_type = std::size_t;
+
+    template <typename Other>
+    struct rebind
+    {
+        using other = PoolAllocator<Other>;
+    };
+
+private:
+    static_assert(alignof(Type) <= alignof(std::max_align_t), "Over-aligned types are not supported by the pool.");
+
+    mutable std::shared_ptr<NodeArena> arena;
+    NodePool * pool;
+
+    const std::shared_ptr<NodeArena>& sharedArena() const
+    {
+        if(!arena)
+            arena = std::make_shared<NodeArena>();
+        return arena;
+    }
+
+    NodePool& getPool()
+    {
+        if(pool == nullptr)
+            pool = &sharedArena()->poolFor(sizeof(Type));
+        return *pool;
+    }
+
+public:
+    PoolAllocator() : pool(nullptr)
+    {}
+
+    PoolAllocator(const PoolAllocator& other)
+    : arena(other.sharedArena()), pool(other.pool)
+    {}
+
+    template <typename Other>
+    PoolAllocator(const PoolAllocator<Other>& other)
+    : arena(other.sharedArena()), pool(nullptr)
+    {}
+
+    PoolAllocator& operator=(const PoolAllocator& other)
+    {
+        arena = other.sharedArena();
+        pool = other.pool;
+        return *this;
+    }
+
+    Type * allocate(size_type count)
+    {
+        if(count == 1)
+            return static_cast<Type*>(getPool().allocate());
+        return static_cast<Type*>(::operator new(count * sizeof(Type)));
+    }
+
+    void deallocate(Type *pointer, size_type count)
+    {
+        if(count == 1)
+            getPool().deallocate(pointer);
+        else
+            ::operator delete(pointer);
+    }
+
+    PoolAllocator select_on_container_copy_construction() const
+    {
+        return PoolAllocator();
+    }
+
+    template <typename Other>
+    bool operator==(const PoolAllocator<Other>& other) const
+    {
+        return sharedArena() == other.sharedArena();
+    }
+
+    template <typename Other>
+    bool operator!=(const PoolAllocator<Other>& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+}
+
+#endif /* AISDI_MAPS_NODEPOOL_H */
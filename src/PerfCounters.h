@@ -0,0 +1,197 @@
+#ifndef AISDI_MAPS_PERFCOUNTERS_H
+#define AISDI_MAPS_PERFCOUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+// Hardware counters of the calling thread, user space only, read through Linux perf_event_open.
+// Counters the kernel or the machine does not provide are left out, so the set may be partial or empty,
+// e.g. in virtual machines without a PMU or when /proc/sys/kernel/perf_event_paranoid forbids it.
+// Each counter is opened on its own, when there are more than the PMU can hold at once the kernel
+// multiplexes them and values are scaled by the fraction of time they were counting.
+class PerfCounters
+{
+public:
+    struct Event
+    {
+        std::string name;
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+
+private:
+    struct Counter
+    {
+        std::string name;
+        int descriptor;
+    };
+
+    std::vector<Counter> counters;
+    std::vector<std::string> unavailable;
+    std::string reason;     // why the last unavailable counter could not be opened
+
+#ifdef __linux__
+    static std::uint64_t cacheEvent(std::uint64_t cache, std::uint64_t operation, std::uint64_t result)
+    {
+        return cache | (operation << 8) | (result << 16);
+    }
+
+    static std::vector<Event> defaultEvents()
+    {
+        return {
+            { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { "L1d-misses", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+            { "LLC-misses", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+            { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { "dTLB-misses", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) }
+        };
+    }
+
+    void open(const Event& event)
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = event.type;
+        attributes.config = event.config;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        long descriptor = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+        if(descriptor < 0)
+        {
+            unavailable.push_back(event.name);
+            reason = event.name + ": " + std::strerror(errno);
+        }
+        else
+            counters.push_back(Counter{event.name, static_cast<int>(descriptor)});
+    }
+
+    void control(unsigned long request)
+    {
+        for(const auto& counter : counters)
+            ioctl(counter.descriptor, request, 0);
+    }
+#else
+    static std::vector<Event> defaultEvents()
+    {
+        return {};
+    }
+#endif
+
+public:
+    PerfCounters() : PerfCounters(defaultEvents())
+    {}
+
+    explicit PerfCounters(const std::vector<Event>& events)
+    {
+#ifdef __linux__
+        for(const auto& event : events)
+            open(event);
+#else
+        (void)events;
+        reason = "performance counters are only supported on Linux";
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for(const auto& counter : counters)
+            close(counter.descriptor);
+#endif
+    }
+
+    std::vector<std::string> names() const // of the counters that could be opened, in the order read() returns
+    {
+        std::vector<std::string> result;
+        for(const auto& counter : counters)
+            result.push_back(counter.name);
+        return result;
+    }
+
+    const std::vector<std::string>& getUnavailable() const
+    {
+        return unavailable;
+    }
+
+    const std::string& getReason() const
+    {
+        return reason;
+    }
+
+#ifdef __linux__
+    void reset()
+    {
+        control(PERF_EVENT_IOC_RESET);
+    }
+
+    void enable()
+    {
+        control(PERF_EVENT_IOC_ENABLE);
+    }
+
+    void disable()
+    {
+        control(PERF_EVENT_IOC_DISABLE);
+    }
+
+    std::vector<double> read() const // events counted while enabled since the last reset()
+    {
+        std::vector<double> values;
+        for(const auto& counter : counters)
+        {
+            std::uint64_t data[3] = { 0, 0, 0 };     // value, time enabled, time running
+            double value = 0.0;
+            if(::read(counter.descriptor, data, sizeof(data)) == static_cast<ssize_t>(sizeof(data)) && data[2] != 0)
+                value = static_cast<double>(data[0]) * data[1] / data[2];
+            values.push_back(value);
+        }
+        return values;
+    }
+#else
+    void reset()
+    {}
+
+    void enable()
+    {}
+
+    void disable()
+    {}
+
+    std::vector<double> read() const
+    {
+        return {};
+    }
+#endif
+};
+
+}
+}
+
+#endif /* AISDI_MAPS_PERFCOUNTERS_H */
@@ -0,0 +1,275 @@
+#ifndef AISDI_MAPS_READMOSTLYHASHMAP_H
+#define AISDI_MAPS_READMOSTLYHASHMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "Epochs.h"
+#include "Hashing.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+// Hash map for many readers and few writers. Readers take no lock and write nothing shared, they only
+// follow atomic pointers inside an Epochs::ReadSection. Writers take turns on one mutex. Elements never
+// change once published: an assignment publishes a new element in place of the old one, and removed links,
+// elements and outgrown bucket arrays are freed by epochs once no reader can still be reading them.
+// Chains are singly linked lists of their own, readers cannot follow ChainedHashTable ones while relinked.
+template <typename KeyType, typename ValueType, typename Hasher = Hash<KeyType>>
+class ReadMostlyHashMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+    using hasher = Hasher;
+
+private:
+    struct Link
+    {
+        size_type hash;
+        std::atomic<const value_type*> element;
+        std::atomic<Link*> next;
+
+        Link(size_type hash, const value_type *element, Link *next) : hash(hash), element(element), next(next)
+        {}
+    };
+
+    struct Table // owns its links, not the elements they point to
+    {
+        size_type mask;
+        std::unique_ptr<std::atomic<Link*>[]> buckets;
+
+        explicit Table(size_type bucketCount) : mask(bucketCount - 1), buckets(new std::atomic<Link*>[bucketCount])
+        {
+            for(size_type i = 0; i < bucketCount; i++)
+                buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        ~Table()
+        {
+            for(size_type i = 0; i <= mask; i++)
+                for(Link *link = buckets[i].load(std::memory_order_relaxed); link != nullptr;)
+                {
+                    Link *next = link->next.load(std::memory_order_relaxed);
+                    delete link;
+                    link = next;
+                }
+        }
+    };
+
+    enum : size_type
+    {
+        minimalBucketCount = 16
+    };
+
+    std::atomic<Table*> table;
+    std::atomic<size_type> size;
+    std::mutex writers;
+    RetiredList retired;    // only touched by writers
+
+    template <typename LookupKey>
+    static size_type hashOf(const LookupKey& key)
+    {
+        return spreadHash<Hasher>(key);
+    }
+
+    const value_type * lookUp(const key_type& key, size_type hash) const // inside a read section
+    {
+        const Table *current = table.load(std::memory_order_acquire);
+        Link *link = current->buckets[hash & current->mask].load(std::memory_order_acquire);
+        for(; link != nullptr; link = link->next.load(std::memory_order_acquire))
+            if(link->hash == hash)
+            {
+                const value_type *element = link->element.load(std::memory_order_acquire);
+                if(element->first == key)
+                    return element;
+            }
+        return nullptr;
+    }
+
+    // Writers only: the pointer that leads to key's link, or to the null ending its chain.
+    std::atomic<Link*> * positionOf(const key_type& key, size_type hash) const
+    {
+        Table *current = table.load(std::memory_order_relaxed);
+        std::atomic<Link*> *position = &current->buckets[hash & current->mask];
+        for(Link *link = position->load(std::memory_order_relaxed); link != nullptr;
+            link = position->load(std::memory_order_relaxed))
+        {
+            if(link->hash == hash && link->element.load(std::memory_order_relaxed)->first == key)
+                break;
+            position = &link->next;
+        }
+        return position;
+    }
+
+    void grow() // readers already in the old table keep finding every element there
+    {
+        Table *old = table.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> grown(new Table(2 * (old->mask + 1)));
+        for(size_type i = 0; i <= old->mask; i++)
+            for(Link *link = old->buckets[i].load(std::memory_order_relaxed); link != nullptr;
+                link = link->next.load(std::memory_order_relaxed))
+            {
+                std::atomic<Link*>& bucket = grown->buckets[link->hash & grown->mask];
+                bucket.store(new Link(link->hash, link->element.load(std::memory_order_relaxed),
+                                      bucket.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            }
+        table.store(grown.release(), std::memory_order_release);
+        retired.retire(old);
+    }
+
+    template <typename... Args>
+    bool insert(size_type hash, Args&&... args) // the key has to be missing, nothing changes if this throws
+    {
+        std::unique_ptr<const value_type> element(new value_type(std::forward<Args>(args)...));
+        std::unique_ptr<Link> link(new Link(hash, element.get(), nullptr));
+        retired.reserve(1);
+        size_type newSize = size.load(std::memory_order_relaxed) + 1;
+        if(newSize > bucketCount())
+            grow();
+
+        Table *current = table.load(std::memory_order_relaxed);
+        std::atomic<Link*>& bucket = current->buckets[hash & current->mask];
+        link->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        bucket.store(link.release(), std::memory_order_release);   // at the front, where readers see it at once
+        element.release();
+        size.store(newSize, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_type bucketCount() const // writers only
+    {
+        return table.load(std::memory_order_relaxed)->mask + 1;
+    }
+
+public:
+    ReadMostlyHashMap() : table(new Table(minimalBucketCount)), size(0)
+    {}
+
+    ReadMostlyHashMap(const ReadMostlyHashMap&) = delete;
+    ReadMostlyHashMap& operator=(const ReadMostlyHashMap&) = delete;
+
+    ~ReadMostlyHashMap() // nobody may be using the map any more
+    {
+        Table *current = table.load();
+        for(size_type i = 0; i <= current->mask; i++)
+            for(Link *link = current->buckets[i].load(); link != nullptr; link = link->next.load())
+                delete link->element.load();
+        delete current;
+    }
+
+    bool find(const key_type& key, mapped_type& value) const // copies the value out, false if key is missing
+    {
+        size_type hash = hashOf(key);
+        Epochs::ReadSection section;
+        const value_type *element = lookUp(key, hash);
+        if(element == nullptr)
+            return false;
+        value = element->second;
+        return true;
+    }
+
+    mapped_type valueOf(const key_type& key) const // a copy
+    {
+        size_type hash = hashOf(key);
+        Epochs::ReadSection section;
+        const value_type *element = lookUp(key, hash);
+        if(element == nullptr)
+            throw std::out_of_range("Attempt to get an element that is not in the map.");
+        return element->second;
+    }
+
+    template <typename... Args>
+    bool try_emplace(const key_type& key, Args&&... args) // true if key was added
+    {
+        size_type hash = hashOf(key);
+        std::lock_guard<std::mutex> lock(writers);
+        std::atomic<Link*> *position = positionOf(key, hash);
+        if(position->load(std::memory_order_relaxed) != nullptr)
+            return false;
+        return insert(hash, std::piecewise_construct, std::forward_as_tuple(key),
+                      std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename Value>
+    bool insert_or_assign(const key_type& key, Value&& value) // true if key was added
+    {
+        size_type hash = hashOf(key);
+        std::lock_guard<std::mutex> lock(writers);
+        std::atomic<Link*> *position = positionOf(key, hash);
+        Link *link = position->load(std::memory_order_relaxed);
+        if(link == nullptr)
+            return insert(hash, key, std::forward<Value>(value));
+
+        std::unique_ptr<const value_type> element(new value_type(key, std::forward<Value>(value)));
+        retired.reserve(1);
+        retired.retire(link->element.exchange(element.release(), std::memory_order_acq_rel));
+        return false;
+    }
+
+    bool erase(const key_type& key) // false if key was missing
+    {
+        size_type hash = hashOf(key);
+        std::lock_guard<std::mutex> lock(writers);
+        std::atomic<Link*> *position = positionOf(key, hash);
+        Link *link = position->load(std::memory_order_relaxed);
+        if(link == nullptr)
+            return false;
+
+        retired.reserve(2);
+        position->store(link->next.load(std::memory_order_relaxed), std::memory_order_release);
+        size.store(size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        retired.retire(link->element.load(std::memory_order_relaxed));
+        retired.retire(link);
+        return true;
+    }
+
+    // Calls function with every element without blocking writers. Elements present for the whole call are
+    // seen exactly once, ones added, replaced or removed meanwhile may or may not be seen.
+    template <typename Function>
+    void for_each(Function function) const
+    {
+        Epochs::ReadSection section;
+        const Table *current = table.load(std::memory_order_acquire);
+        for(size_type i = 0; i <= current->mask; i++)
+            for(Link *link = current->buckets[i].load(std::memory_order_acquire); link != nullptr;
+                link = link->next.load(std::memory_order_acquire))
+                function(*link->element.load(std::memory_order_acquire));
+    }
+
+    size_type getSize() const
+    {
+        return size.load(std::memory_order_relaxed);
+    }
+
+    bool isEmpty() const
+    {
+        return getSize() == 0;
+    }
+
+    size_type bucket_count() const
+    {
+        Epochs::ReadSection section;
+        return table.load(std::memory_order_acquire)->mask + 1;
+    }
+
+    MemoryUsage memoryUsage() // counts what waits for readers to leave as well
+    {
+        std::lock_guard<std::mutex> lock(writers);
+        size_type elements = size.load(std::memory_order_relaxed);
+        return MemoryUsage{sizeof(*this) + bucketCount() * sizeof(std::atomic<Link*>)
+                           + elements * (sizeof(Link) + sizeof(value_type)) + retired.memoryUsage(),
+                           elements * sizeof(value_type)};
+    }
+};
+
+}
+
+#endif /* AISDI_MAPS_READMOSTLYHASHMAP_H */
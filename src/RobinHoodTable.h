@@ -0,0 +1,548 @@
+#ifndef AISDI_MAPS_ROBINHOODTABLE_H
+#define AISDI_MAPS_ROBINHOODTABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Hashing.h"
+#include "MemoryUsage.h"
+
+namespace aisdi
+{
+
+// Linear probing where an element never sits further from its home slot than the one it passes,
+// so probe lengths stay close to the mean. Removal shifts the following run back, no tombstones.
+template <typename KeyType, typename ValueType, typename Hasher = Hash<KeyType>>
+class RobinHoodHashTable
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+    using Handle = size_type; // slot index, capacity is used for the end
+
+private:
+    using Distance = std::uint16_t; // distance from the home slot plus one, zero marks an empty slot
+    using Slot = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+    enum : size_type
+    {
+        minimalCapacity = 8,
+        distanceLimit = 0xFFFE, // keeps the probing distance from wrapping around
+        maxRunGrowth = 8        // how much bigger a table may get to shorten an overlong run
+    };
+
+    Distance * distances;
+    Slot * slots;
+    size_type capacity;     // zero or a power of two
+    size_type size;
+    float maxLoadFactor;
+
+    template <typename LookupKey>
+    static size_type hashOf(const LookupKey& key)
+    {
+        return spreadHash<Hasher>(key);
+    }
+
+    size_type homeSlot(size_type hash) const
+    {
+        return hash & (capacity - 1);
+    }
+
+    size_type nextSlot(size_type slot) const
+    {
+        return (slot + 1) & (capacity - 1);
+    }
+
+    size_type prevSlot(size_type slot) const
+    {
+        return (slot - 1) & (capacity - 1);
+    }
+
+    value_type& element(size_type slot) const
+    {
+        return *reinterpret_cast<value_type*>(slots + slot);
+    }
+
+    void moveElement(size_type from, size_type to) // to has to be empty, from is empty afterwards
+    {
+        new (slots + to) value_type(std::move(element(from)));
+        element(from).~value_type();
+    }
+
+    size_type growthLimit(size_type slotCount) const // at least one slot stays empty
+    {
+        auto limit = static_cast<size_type>(slotCount * maxLoadFactor);
+        return limit < slotCount ? limit : slotCount - 1;
+    }
+
+    size_type capacityFor(size_type elements) const
+    {
+        size_type slotCount = minimalCapacity;
+        while(growthLimit(slotCount) < elements)
+            slotCount *= 2;
+        return slotCount;
+    }
+
+    // Probes until the key or the first slot whose element is closer to home than the key would be.
+    // Returns that slot and the key's distance there, found tells which of the two it is.
+    template <typename LookupKey>
+    size_type probe(const LookupKey& key, size_type hash, Distance& distance, bool& found) const
+    {
+        size_type slot = homeSlot(hash);
+        distance = 1;
+        while(distances[slot] >= distance)
+        {
+            if(distances[slot] == distance && element(slot).first == key)
+            {
+                found = true;
+                return slot;
+            }
+            slot = nextSlot(slot);
+            distance++;
+        }
+        found = false;
+        return slot;
+    }
+
+    bool placeAt(size_type slot, Distance distance) // shifts the run starting at slot one place forward
+    {
+        size_type emptySlot = slot;
+        while(distances[emptySlot] != 0)
+        {
+            if(distances[emptySlot] == distanceLimit)
+                return false;
+            emptySlot = nextSlot(emptySlot);
+        }
+        if(distance == distanceLimit)
+            return false;
+
+        for(; emptySlot != slot; emptySlot = prevSlot(emptySlot))
+        {
+            moveElement(prevSlot(emptySlot), emptySlot);
+            distances[emptySlot] = distances[prevSlot(emptySlot)] + 1;
+        }
+        distances[slot] = distance;
+        return true;
+    }
+
+    void shiftBack(size_type slot) // slot was emptied, the rest of its run moves one slot closer to home
+    {
+        for(size_type following = nextSlot(slot); distances[following] > 1; following = nextSlot(following))
+        {
+            moveElement(following, slot);
+            distances[slot] = distances[following] - 1;
+            slot = following;
+        }
+        distances[slot] = 0;
+    }
+
+    void alloc(size_type slotCount)
+    {
+        capacity = slotCount;
+        distances = new Distance[capacity]();
+        slots = new Slot[capacity];
+    }
+
+    void dealloc() // destroys elements and leaves a table without slots
+    {
+        for(size_type slot = 0; slot < capacity; slot++)
+            if(distances[slot] != 0)
+                element(slot).~value_type();
+        delete [] distances;
+        delete [] slots;
+        distances = nullptr;
+        slots = nullptr;
+        capacity = 0;
+        size = 0;
+    }
+
+    // This has no slots, and has none again if copying throws. Layout of other is kept.
+    void copyFrom(const RobinHoodHashTable& other)
+    {
+        maxLoadFactor = other.maxLoadFactor;
+        if(other.capacity == 0)
+            return;
+
+        alloc(other.capacity);
+        try
+        {
+            for(size_type slot = 0; slot < capacity; slot++)
+                if(other.distances[slot] != 0)
+                {
+                    new (slots + slot) value_type(other.element(slot));
+                    distances[slot] = other.distances[slot];
+                    size++;
+                }
+        }
+        catch(...)
+        {
+            dealloc();  // only the slots copied so far have a distance
+            throw;
+        }
+    }
+
+    void stealFrom(RobinHoodHashTable& other)
+    {
+        distances = other.distances;
+        slots = other.slots;
+        capacity = other.capacity;
+        size = other.size;
+        maxLoadFactor = other.maxLoadFactor;
+        other.distances = nullptr;
+        other.slots = nullptr;
+        other.capacity = 0;
+        other.size = 0;
+    }
+
+    // Places an element of hash as probe() and placeAt() would, into layout only, where origins tell which
+    // slot of this table every element comes from. Returns false, leaving layout as it was, if it cannot.
+    static bool placeInLayout(Distance *layout, size_type *origins, size_type slotCount, size_type hash,
+                              size_type origin)
+    {
+        size_type mask = slotCount - 1;
+        size_type slot = hash & mask;
+        Distance distance = 1;
+        while(layout[slot] >= distance)
+        {
+            slot = (slot + 1) & mask;
+            distance++;
+        }
+
+        size_type emptySlot = slot;
+        while(layout[emptySlot] != 0)
+        {
+            if(layout[emptySlot] == distanceLimit)
+                return false;
+            emptySlot = (emptySlot + 1) & mask;
+        }
+        if(distance == distanceLimit)
+            return false;
+
+        for(; emptySlot != slot; emptySlot = (emptySlot - 1) & mask)
+        {
+            layout[emptySlot] = layout[(emptySlot - 1) & mask] + 1;
+            origins[emptySlot] = origins[(emptySlot - 1) & mask];
+        }
+        layout[slot] = distance;
+        origins[slot] = origin;
+        return true;
+    }
+
+    // Lays the elements out in slotCount slots in the order resize() moves them, false if a run overflows.
+    bool layOut(Distance *layout, size_type *origins, size_type slotCount) const
+    {
+        for(size_type slot = 0; slot < capacity; slot++)
+            if(distances[slot] != 0 && !placeInLayout(layout, origins, slotCount, hashOf(element(slot).first), slot))
+                return false;
+        return true;
+    }
+
+    bool fitsWith(size_type slotCount, size_type hash) const // the elements and one more of hash
+    {
+        std::unique_ptr<Distance[]> layout(new Distance[slotCount]());
+        std::unique_ptr<size_type[]> origins(new size_type[slotCount]);
+        return layOut(layout.get(), origins.get(), slotCount)
+               && placeInLayout(layout.get(), origins.get(), slotCount, hash, capacity);
+    }
+
+    // Elements whose move may throw are copied and the originals destroyed only once all are in,
+    // so the table keeps its elements if this throws.
+    void resize(size_type slotCount)
+    {
+        std::unique_ptr<Distance[]> layout(new Distance[slotCount]());
+        std::unique_ptr<size_type[]> origins(new size_type[slotCount]);
+        if(!layOut(layout.get(), origins.get(), slotCount))
+            throw std::length_error("Probe distance limit exceeded, keys hash too badly.");
+
+        std::unique_ptr<Slot[]> newSlots(new Slot[slotCount]);
+        size_type built = 0;
+        try
+        {
+            for(; built < slotCount; built++)
+                if(layout[built] != 0)
+                    new (newSlots.get() + built) value_type(std::move_if_noexcept(element(origins[built])));
+        }
+        catch(...)
+        {
+            for(size_type slot = 0; slot < built; slot++)
+                if(layout[slot] != 0)
+                    reinterpret_cast<value_type*>(newSlots.get() + slot)->~value_type();
+            throw;
+        }
+
+        for(size_type slot = 0; slot < capacity; slot++)
+            if(distances[slot] != 0)
+                element(slot).~value_type();
+        delete [] distances;
+        delete [] slots;
+        distances = layout.release();
+        slots = newSlots.release();
+        capacity = slotCount;
+    }
+
+public:
+    RobinHoodHashTable()
+    : distances(nullptr), slots(nullptr), capacity(0), size(0), maxLoadFactor(0.9f)
+    {}
+
+    RobinHoodHashTable(const RobinHoodHashTable& other)
+    : distances(nullptr), slots(nullptr), capacity(0), size(0)
+    {
+        copyFrom(other);
+    }
+
+    RobinHoodHashTable(RobinHoodHashTable&& other)
+    {
+        stealFrom(other);
+    }
+
+    ~RobinHoodHashTable()
+    {
+        dealloc();
+    }
+
+    RobinHoodHashTable& operator=(const RobinHoodHashTable& other)
+    {
+        if(&other == this)
+            return *this;
+
+        RobinHoodHashTable copy(other);
+        return *this = std::move(copy);
+    }
+
+    RobinHoodHashTable& operator=(RobinHoodHashTable&& other)
+    {
+        if(&other == this)
+            return *this;
+
+        dealloc();
+        stealFrom(other);
+        return *this;
+    }
+
+    size_type getSize() const
+    {
+        return size;
+    }
+
+    Handle endHandle() const
+    {
+        return capacity;
+    }
+
+    Handle first() const
+    {
+        return next(static_cast<Handle>(-1));
+    }
+
+    Handle next(Handle position) const
+    {
+        for(position++; position < capacity; position++)
+            if(distances[position] != 0)
+                break;
+        return position;
+    }
+
+    Handle prev(Handle position) const // the end for first()
+    {
+        while(position > 0)
+            if(distances[--position] != 0)
+                return position;
+        return endHandle();
+    }
+
+    const value_type& get(const Handle& position) const
+    {
+        return element(position);
+    }
+
+    value_type& get(const Handle& position)
+    {
+        return element(position);
+    }
+
+    template <typename LookupKey>
+    Handle find(const LookupKey& key) const
+    {
+        if(size == 0)
+            return endHandle();
+
+        Distance distance;
+        bool found;
+        size_type slot = probe(key, hashOf(key), distance, found);
+        return found ? slot : endHandle();
+    }
+
+    template <typename LookupKey>
+    Handle findHashed(const LookupKey& key, size_type hash) const // hash is spreadHash<Hasher>(key)
+    {
+        if(size == 0)
+            return endHandle();
+
+        Distance distance;
+        bool found;
+        size_type slot = probe(key, hash, distance, found);
+        return found ? slot : endHandle();
+    }
+
+    // Constructs the value from args if key is missing, key is moved in when passed as an rvalue.
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplace(Key&& key, Args&&... args)
+    {
+        return tryEmplaceHashed(hashOf(key), std::forward<Key>(key), std::forward<Args>(args)...);
+    }
+
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplaceHashed(size_type hash, Key&& key, Args&&... args)
+    {
+        Distance distance;
+        bool found;
+        if(capacity != 0)
+        {
+            size_type slot = probe(key, hash, distance, found);
+            if(found)
+                return std::make_pair(slot, false);
+            // a free slot in a table with room takes the element without moving others, it is built in place
+            if(distances[slot] == 0 && distance != distanceLimit && size + 1 <= growthLimit(capacity))
+            {
+                new (slots + slot) value_type(std::piecewise_construct,
+                                              std::forward_as_tuple(std::forward<Key>(key)),
+                                              std::forward_as_tuple(std::forward<Args>(args)...));
+                distances[slot] = distance;
+                size++;
+                return std::make_pair(slot, true);
+            }
+        }
+
+        // Elements move to make room, args may refer to one of them, so the new one is built aside first.
+        value_type inserted(std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+        if(capacity == 0 || size + 1 > growthLimit(capacity))
+            resize(capacityFor(size + 1));
+
+        size_type slot = probe(inserted.first, hash, distance, found);
+        if(!placeAt(slot, distance))    // an overlong run, a bigger table shortens it unless the hashes are equal
+        {
+            size_type slotCount = capacity * 2;
+            while(!fitsWith(slotCount, hash))
+            {
+                if(slotCount >= capacity * maxRunGrowth)
+                    throw std::length_error("Probe distance limit exceeded, keys hash too badly.");
+                slotCount *= 2;
+            }
+            resize(slotCount);  // lays the elements out as fitsWith() did, so the key has its place
+            slot = probe(inserted.first, hash, distance, found);
+            placeAt(slot, distance);
+        }
+
+        try
+        {
+            new (slots + slot) value_type(std::move(inserted));
+        }
+        catch(...)
+        {
+            shiftBack(slot);
+            throw;
+        }
+        size++;
+        return std::make_pair(slot, true);
+    }
+
+    Handle findOrInsert(const key_type& key) // inserts a value initialized value if key is missing
+    {
+        return tryEmplace(key).first;
+    }
+
+    void erase(const Handle& position)
+    {
+        element(position).~value_type();
+        size--;
+        shiftBack(position);
+    }
+
+    size_type bucket_count() const
+    {
+        return capacity;
+    }
+
+    float load_factor() const
+    {
+        if(capacity == 0)
+            return 0.0f;
+        return static_cast<float>(size) / capacity;
+    }
+
+    float max_load_factor() const
+    {
+        return maxLoadFactor;
+    }
+
+    void max_load_factor(float factor) // at least one slot is always kept empty, whatever the factor
+    {
+        if(!(factor > 0.0f))
+            throw std::invalid_argument("Maximum load factor has to be positive.");
+
+        maxLoadFactor = factor;
+        if(capacity != 0 && size > growthLimit(capacity))
+            resize(capacityFor(size));
+    }
+
+    void reserve(size_type elements)
+    {
+        if(capacityFor(elements) > capacity)
+            resize(capacityFor(elements));
+    }
+
+    void rehash(size_type count) // slot count is a power of two, never below what size requires
+    {
+        size_type slotCount = capacityFor(size);
+        while(slotCount < count)
+            slotCount *= 2;
+        if(slotCount != capacity)
+            resize(slotCount);
+    }
+
+    size_type maxProbeLength() const // slots inspected by the longest successful lookup, O(bucket_count())
+    {
+        Distance longest = 0;
+        for(size_type slot = 0; slot < capacity; slot++)
+            longest = std::max(longest, distances[slot]);
+        return longest;
+    }
+
+    double meanProbeLength() const // slots inspected by an average successful lookup, O(bucket_count())
+    {
+        if(size == 0)
+            return 0.0;
+
+        double total = 0.0;
+        for(size_type slot = 0; slot < capacity; slot++)
+            total += distances[slot];
+        return total / size;
+    }
+
+    MemoryUsage memoryUsage() const
+    {
+        return MemoryUsage{sizeof(*this) + capacity * (sizeof(Distance) + sizeof(Slot)), size * sizeof(value_type)};
+    }
+};
+
+struct RobinHood // HashMap policy
+{
+    template <typename KeyType, typename ValueType, typename Allocator, typename Hasher>
+    using Table = RobinHoodHashTable<KeyType, ValueType, Hasher>; // slots live in one array, no node allocations
+};
+
+}
+
+#endif /* AISDI_MAPS_ROBINHOODTABLE_H */
@@ -0,0 +1,527 @@
+#ifndef AISDI_MAPS_SWISSTABLE_H
+#define AISDI_MAPS_SWISSTABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Hashing.h"
+#include "MemoryUsage.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace aisdi
+{
+
+// Open addressing with a control byte per slot, probed 16 slots (one group) at a time.
+// A control byte is either empty, deleted (tombstone) or holds the 7 low bits of the hash (h2).
+template <typename KeyType, typename ValueType, typename Hasher = Hash<KeyType>>
+class SwissHashTable
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+    using Handle = size_type; // slot index, capacity is used for the end
+
+private:
+    using Control = std::int8_t;
+    using Slot = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+    using Mask = std::uint32_t; // one bit per slot of a group
+
+    enum : Control
+    {
+        empty = -128,   // 0b10000000
+        deleted = -2    // 0b11111110
+    };                  // both have the sign bit set, full slots do not
+
+    enum : size_type
+    {
+        groupWidth = 16
+    };
+
+    static size_type lowestBit(Mask mask)
+    {
+        return static_cast<size_type>(__builtin_ctz(mask));
+    }
+
+    class Group // 16 control bytes compared at once
+    {
+#ifdef __SSE2__
+        __m128i bytes;
+    public:
+        explicit Group(const Control * position)
+        : bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position)))
+        {}
+
+        Mask match(Control hash) const
+        {
+            return static_cast<Mask>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), bytes)));
+        }
+
+        Mask matchEmptyOrDeleted() const
+        {
+            return static_cast<Mask>(_mm_movemask_epi8(bytes));
+        }
+#else
+        const Control * bytes;
+    public:
+        explicit Group(const Control * position) : bytes(position)
+        {}
+
+        Mask match(Control hash) const
+        {
+            Mask mask = 0;
+            for(size_type i = 0; i < groupWidth; i++)
+                if(bytes[i] == hash)
+                    mask |= Mask{1} << i;
+            return mask;
+        }
+
+        Mask matchEmptyOrDeleted() const
+        {
+            Mask mask = 0;
+            for(size_type i = 0; i < groupWidth; i++)
+                if(bytes[i] < 0)
+                    mask |= Mask{1} << i;
+            return mask;
+        }
+#endif
+        Mask matchEmpty() const
+        {
+            return match(empty);
+        }
+
+        Mask matchFull() const
+        {
+            return ~matchEmptyOrDeleted() & 0xFFFF;
+        }
+    };
+
+    Control * controls;
+    Slot * slots;
+    size_type capacity;     // zero or a power of two, not smaller than a group
+    size_type size;
+    size_type growthLeft;   // insertions into empty slots allowed before rehashing
+    float maxLoadFactor;
+
+    template <typename LookupKey>
+    static size_type hashOf(const LookupKey& key)
+    {
+        return spreadHash<Hasher>(key);
+    }
+
+    static Control h2(size_type hash)
+    {
+        return static_cast<Control>(hash & 0x7F);
+    }
+
+    size_type firstGroup(size_type hash) const // h1 picks where probing starts
+    {
+        return (hash >> 7) & (capacity / groupWidth - 1);
+    }
+
+    size_type nextGroup(size_type group, size_type step) const // triangular probing visits every group
+    {
+        return (group + step) & (capacity / groupWidth - 1);
+    }
+
+    value_type& element(size_type slot) const
+    {
+        return *reinterpret_cast<value_type*>(slots + slot);
+    }
+
+    size_type growthLimit(size_type slotCount) const // at least one slot stays empty, so probing always stops
+    {
+        auto limit = static_cast<size_type>(slotCount * maxLoadFactor);
+        return limit < slotCount ? limit : slotCount - 1;
+    }
+
+    size_type capacityFor(size_type elements) const
+    {
+        size_type slotCount = groupWidth;
+        while(growthLimit(slotCount) < elements)
+            slotCount *= 2;
+        return slotCount;
+    }
+
+    template <typename LookupKey>
+    Handle find(const LookupKey& key, size_type hash) const
+    {
+        size_type group = firstGroup(hash);
+        for(size_type step = 1; true; step++)
+        {
+            Group g(controls + group * groupWidth);
+            for(Mask mask = g.match(h2(hash)); mask != 0; mask &= mask - 1)
+            {
+                size_type slot = group * groupWidth + lowestBit(mask);
+                if(element(slot).first == key)
+                    return slot;
+            }
+            if(g.matchEmpty() != 0) // key would have been placed here
+                return endHandle();
+            group = nextGroup(group, step);
+        }
+    }
+
+    size_type findInsertSlot(size_type hash) const
+    {
+        size_type group = firstGroup(hash);
+        for(size_type step = 1; true; step++)
+        {
+            Mask mask = Group(controls + group * groupWidth).matchEmptyOrDeleted();
+            if(mask != 0)
+                return group * groupWidth + lowestBit(mask);
+            group = nextGroup(group, step);
+        }
+    }
+
+    size_type nextFull(size_type slot) const
+    {
+        while(slot < capacity)
+        {
+            size_type group = slot / groupWidth;
+            Mask mask = Group(controls + group * groupWidth).matchFull() >> (slot % groupWidth);
+            if(mask != 0)
+                return slot + lowestBit(mask);
+            slot = (group + 1) * groupWidth;
+        }
+        return capacity;
+    }
+
+    void alloc(size_type slotCount)
+    {
+        capacity = slotCount;
+        controls = new Control[capacity];
+        std::memset(controls, empty, capacity);
+        slots = new Slot[capacity];
+        growthLeft = growthLimit(capacity);
+    }
+
+    void dealloc() // destroys elements and leaves a table without slots
+    {
+        for(size_type slot = nextFull(0); slot < capacity; slot = nextFull(slot + 1))
+            element(slot).~value_type();
+        delete [] controls;
+        delete [] slots;
+        controls = nullptr;
+        slots = nullptr;
+        capacity = 0;
+        size = 0;
+        growthLeft = 0;
+    }
+
+    void copyFrom(const SwissHashTable& other) // this has no slots, and has none again if copying throws
+    {
+        maxLoadFactor = other.maxLoadFactor;
+        if(other.capacity == 0)
+            return;
+
+        alloc(other.capacity);
+        try
+        {
+            for(size_type slot = other.nextFull(0); slot < other.capacity; slot = other.nextFull(slot + 1))
+            {
+                new (slots + slot) value_type(other.element(slot));
+                controls[slot] = other.controls[slot];
+                size++;
+            }
+        }
+        catch(...)
+        {
+            dealloc();  // only the slots copied so far are marked full
+            throw;
+        }
+        growthLeft = other.growthLeft;
+        std::memcpy(controls, other.controls, capacity); // tombstones of other are kept so that growthLeft holds
+    }
+
+    void stealFrom(SwissHashTable& other)
+    {
+        controls = other.controls;
+        slots = other.slots;
+        capacity = other.capacity;
+        size = other.size;
+        growthLeft = other.growthLeft;
+        maxLoadFactor = other.maxLoadFactor;
+        other.controls = nullptr;
+        other.slots = nullptr;
+        other.capacity = 0;
+        other.size = 0;
+        other.growthLeft = 0;
+    }
+
+    // This has room for them, other keeps its slots, all empty. Elements whose move may throw are copied and
+    // the originals destroyed only once all are in, so other keeps its elements if this throws.
+    void moveElementsFrom(SwissHashTable& other)
+    {
+        for(size_type slot = other.nextFull(0); slot < other.capacity; slot = other.nextFull(slot + 1))
+        {
+            value_type& moved = other.element(slot);
+            size_type hash = hashOf(moved.first);
+            size_type target = findInsertSlot(hash);
+            new (slots + target) value_type(std::move_if_noexcept(moved));
+            controls[target] = h2(hash);
+            growthLeft--;
+            size++;
+        }
+        for(size_type slot = other.nextFull(0); slot < other.capacity; slot = other.nextFull(slot + 1))
+            other.element(slot).~value_type();
+        if(other.capacity != 0) // memset takes no null pointer, even for no bytes
+            std::memset(other.controls, empty, other.capacity);
+        other.size = 0;
+    }
+
+    SwissHashTable withSlots(size_type slotCount) const // empty, with the same maximum load factor
+    {
+        SwissHashTable table;
+        table.maxLoadFactor = maxLoadFactor;
+        table.alloc(slotCount);
+        return table;
+    }
+
+    void resize(size_type slotCount) // rebuilds the table, which also drops all tombstones
+    {
+        SwissHashTable resized = withSlots(slotCount);
+        resized.moveElementsFrom(*this);
+        *this = std::move(resized);
+    }
+
+    size_type grownCapacity() const // for a table with no room for another insertion
+    {
+        if(capacity == 0)
+            return capacityFor(1);
+        if(size < growthLimit(capacity) / 2)    // mostly tombstones, cleaning them up is enough
+            return capacity;
+        return capacity * 2;
+    }
+
+    // The new element is built before the others move, as args may refer to one of them.
+    template <typename... Args>
+    Handle emplaceGrowing(size_type hash, Args&&... args)
+    {
+        SwissHashTable grown = withSlots(grownCapacity());
+        size_type slot = grown.findInsertSlot(hash);
+        new (grown.slots + slot) value_type(std::forward<Args>(args)...);
+        grown.controls[slot] = h2(hash);
+        grown.growthLeft--;
+        grown.size++;
+        grown.moveElementsFrom(*this);
+        *this = std::move(grown);
+        return slot;
+    }
+
+public:
+    SwissHashTable()
+    : controls(nullptr), slots(nullptr), capacity(0), size(0), growthLeft(0), maxLoadFactor(0.875f)
+    {}
+
+    SwissHashTable(const SwissHashTable& other)
+    : controls(nullptr), slots(nullptr), capacity(0), size(0), growthLeft(0)
+    {
+        copyFrom(other);
+    }
+
+    SwissHashTable(SwissHashTable&& other)
+    {
+        stealFrom(other);
+    }
+
+    ~SwissHashTable()
+    {
+        dealloc();
+    }
+
+    SwissHashTable& operator=(const SwissHashTable& other)
+    {
+        if(&other == this)
+            return *this;
+
+        SwissHashTable copy(other);
+        return *this = std::move(copy);
+    }
+
+    SwissHashTable& operator=(SwissHashTable&& other)
+    {
+        if(&other == this)
+            return *this;
+
+        dealloc();
+        stealFrom(other);
+        return *this;
+    }
+
+    size_type getSize() const
+    {
+        return size;
+    }
+
+    Handle endHandle() const
+    {
+        return capacity;
+    }
+
+    Handle first() const
+    {
+        return nextFull(0);
+    }
+
+    Handle next(Handle position) const
+    {
+        return nextFull(position + 1);
+    }
+
+    Handle prev(Handle position) const // the end for first()
+    {
+        while(position > 0)
+            if(controls[--position] >= 0)
+                return position;
+        return endHandle();
+    }
+
+    const value_type& get(const Handle& position) const
+    {
+        return element(position);
+    }
+
+    value_type& get(const Handle& position)
+    {
+        return element(position);
+    }
+
+    template <typename LookupKey>
+    Handle find(const LookupKey& key) const
+    {
+        if(size == 0)
+            return endHandle();
+        return find(key, hashOf(key));
+    }
+
+    template <typename LookupKey>
+    Handle findHashed(const LookupKey& key, size_type hash) const // hash is spreadHash<Hasher>(key)
+    {
+        if(size == 0)
+            return endHandle();
+        return find(key, hash);
+    }
+
+    // Constructs the value from args if key is missing, key is moved in when passed as an rvalue.
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplace(Key&& key, Args&&... args)
+    {
+        return tryEmplaceHashed(hashOf(key), std::forward<Key>(key), std::forward<Args>(args)...);
+    }
+
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplaceHashed(size_type hash, Key&& key, Args&&... args)
+    {
+        if(size != 0)
+        {
+            auto position = find(key, hash);
+            if(position != endHandle())
+                return std::make_pair(position, false);
+        }
+
+        size_type slot = capacity == 0 ? 0 : findInsertSlot(hash);
+        if(capacity == 0 || (growthLeft == 0 && controls[slot] == empty))
+        {
+            slot = emplaceGrowing(hash, std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+            return std::make_pair(slot, true);
+        }
+
+        new (slots + slot) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+        if(controls[slot] == empty)
+            growthLeft--;
+        controls[slot] = h2(hash);
+        size++;
+        return std::make_pair(slot, true);
+    }
+
+    Handle findOrInsert(const key_type& key) // inserts a value initialized value if key is missing
+    {
+        return tryEmplace(key).first;
+    }
+
+    void erase(const Handle& position)
+    {
+        element(position).~value_type();
+        size--;
+
+        // a group with an empty slot never made any probe go further, so no tombstone is needed
+        if(Group(controls + position / groupWidth * groupWidth).matchEmpty() != 0)
+        {
+            controls[position] = empty;
+            growthLeft++;
+        }
+        else
+            controls[position] = deleted;
+    }
+
+    size_type bucket_count() const
+    {
+        return capacity;
+    }
+
+    float load_factor() const
+    {
+        if(capacity == 0)
+            return 0.0f;
+        return static_cast<float>(size) / capacity;
+    }
+
+    float max_load_factor() const
+    {
+        return maxLoadFactor;
+    }
+
+    void max_load_factor(float factor) // at least one slot is always kept empty, whatever the factor
+    {
+        if(!(factor > 0.0f))
+            throw std::invalid_argument("Maximum load factor has to be positive.");
+
+        maxLoadFactor = factor;
+        if(capacity != 0)
+            resize(std::max(capacity, capacityFor(size)));
+    }
+
+    void reserve(size_type elements)
+    {
+        if(capacityFor(elements) > capacity)
+            resize(capacityFor(elements));
+    }
+
+    void rehash(size_type count) // slot count is a power of two, never below what size requires
+    {
+        size_type slotCount = capacityFor(size);
+        while(slotCount < count)
+            slotCount *= 2;
+        if(slotCount != capacity)
+            resize(slotCount);
+    }
+
+    MemoryUsage memoryUsage() const
+    {
+        return MemoryUsage{sizeof(*this) + capacity * (sizeof(Control) + sizeof(Slot)), size * sizeof(value_type)};
+    }
+};
+
+struct SwissTable // HashMap policy
+{
+    template <typename KeyType, typename ValueType, typename Allocator, typename Hasher>
+    using Table = SwissHashTable<KeyType, ValueType, Hasher>; // slots live in one array, no node allocations
+};
+
+}
+
+#endif /* AISDI_MAPS_SWISSTABLE_H */
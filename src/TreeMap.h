@@ -3,67 +3,105 @@
 
 #include <cstddef>
 #include <initializer_list>
+#include <iterator>
 #include <stdexcept>
 #include <utility>
+#include <memory>
+#include <new>
+#include <tuple>
+#include "BPlusTree.h"
+#include "Lookup.h"
+#include "MemoryUsage.h"
+#include "NodePool.h"
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
-class TreeMap
+// Red-black tree, one node per element.
+template <typename KeyType, typename ValueType, typename Allocator = PoolAllocator<std::pair<const KeyType, ValueType>>>
+class RedBlackTree
 {
 public:
     using key_type = KeyType;
     using mapped_type = ValueType;
     using value_type = std::pair<const key_type, mapped_type>;
     using size_type = std::size_t;
-    using reference = value_type&;
-    using const_reference = const value_type&;
 
-    class ConstIterator;
-    class Iterator;
-    using iterator = Iterator;
-    using const_iterator = ConstIterator;
-protected:
+private:
+    enum class Color : unsigned char
+    {
+        red,
+        black   // missing (nullptr) children count as black
+    };
+
     struct Node
     {
         Node * left;
         Node * right;
         Node * parent;
+        Color color;
         value_type data;
-        Node() {}
-        Node(const key_type& key)
-        : left(nullptr), right(nullptr), data( std::make_pair(key, mapped_type {}) )
+        Node() : color(Color::black) {}
+        template <typename... KeyArgs, typename... Args> // a new, red node
+        Node(std::piecewise_construct_t, std::tuple<KeyArgs...> key, std::tuple<Args...> args)
+        : left(nullptr), right(nullptr), color(Color::red), data(std::piecewise_construct, std::move(key), std::move(args))
+        {
+
+        }
+        Node(const key_type& key, const mapped_type& value, Color nodeColor)
+        : left(nullptr), right(nullptr), color(nodeColor), data(key, value)
+        {
+
+        }
+        Node(const Node& other) // copies the element and the color, not the links
+        : left(nullptr), right(nullptr), parent(nullptr), color(other.color), data(other.data)
         {
 
         }
     }
-    * head; // sentinel
+    sentinel;   // part of the tree, so an empty tree allocates nothing
+    Node * head; // the sentinel, head->left is the root and the root's parent is head
     size_type size; // number of elements in the tree
 
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+    NodeAllocator allocator;
+
+public:
+    using Handle = Node*; // head is used for the end
+
+private:
+    template <typename... Args>
+    Node * createNode(Args&&... args)
+    {
+        Node * node = NodeAllocatorTraits::allocate(allocator, 1);
+        try
+        {
+            new (node) Node(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            NodeAllocatorTraits::deallocate(allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroyNode(Node * node)
+    {
+        node->~Node();
+        NodeAllocatorTraits::deallocate(allocator, node, 1);
+    }
+
     void initTree()
     {
-        head = new Node();
+        head = &sentinel;
         head->left = head;          // required to detect empty list
-        head->right = head;         // used for detecting illegal --begin() with empty collection
+        head->right = head;
         head->parent = nullptr;     // because sentinel has no parent
         size = 0;
     }
 
-    const_iterator search(Node *startNode, const key_type& key) const // searches if key is found in the given tree
-    {
-        while(startNode != nullptr)
-        {
-            if(key == startNode->data.first)
-                return const_iterator(startNode);
-            if(key < startNode->data.first)
-                startNode = startNode->left;
-            else
-                startNode = startNode->right;
-        }
-        return cend(); // if not, end() iterator is returned
-    }
-
     Node* getMinimalSubtreeNode(Node *node) // search for the smallest element in the left subtree
     {
         while(node->left != nullptr)
@@ -84,182 +122,529 @@ protected:
             node2->parent = node1->parent;
     }
 
-    void deallocTree(Node *node) // deallocs subtree, does not set parent to null!
+    static bool isRed(const Node *node)
+    {
+        return node != nullptr && node->color == Color::red;
+    }
+
+    void rotateLeft(Node *node) // node's right child takes its place, works for the root as head->left is the root
+    {
+        Node *child = node->right;
+        node->right = child->left;
+        if(child->left != nullptr)
+            child->left->parent = node;
+
+        child->parent = node->parent;
+        if(node == node->parent->left)
+            node->parent->left = child;
+        else
+            node->parent->right = child;
+
+        child->left = node;
+        node->parent = child;
+    }
+
+    void rotateRight(Node *node) // mirror of rotateLeft
+    {
+        Node *child = node->left;
+        node->left = child->right;
+        if(child->right != nullptr)
+            child->right->parent = node;
+
+        child->parent = node->parent;
+        if(node == node->parent->right)
+            node->parent->right = child;
+        else
+            node->parent->left = child;
+
+        child->right = node;
+        node->parent = child;
+    }
+
+    void fixAfterInsertion(Node *node) // node is red, its parent may be red too
+    {
+        while(node->parent != head && isRed(node->parent)) // red parent is never the root, so grandparent exists
+        {
+            Node *parent = node->parent;
+            Node *grandparent = parent->parent;
+            if(parent == grandparent->left)
+            {
+                Node *uncle = grandparent->right;
+                if(isRed(uncle))                // recolor and continue from the grandparent
+                {
+                    parent->color = Color::black;
+                    uncle->color = Color::black;
+                    grandparent->color = Color::red;
+                    node = grandparent;
+                    continue;
+                }
+                if(node == parent->right)       // make the red-red pair an outer one
+                {
+                    rotateLeft(parent);
+                    parent = node;
+                }
+                parent->color = Color::black;
+                grandparent->color = Color::red;
+                rotateRight(grandparent);
+                break;      // subtree top is black now
+            }
+            else
+            {
+                Node *uncle = grandparent->left;
+                if(isRed(uncle))
+                {
+                    parent->color = Color::black;
+                    uncle->color = Color::black;
+                    grandparent->color = Color::red;
+                    node = grandparent;
+                    continue;
+                }
+                if(node == parent->left)
+                {
+                    rotateRight(parent);
+                    parent = node;
+                }
+                parent->color = Color::black;
+                grandparent->color = Color::red;
+                rotateLeft(grandparent);
+                break;      // subtree top is black now
+            }
+        }
+        head->left->color = Color::black;
+    }
+
+    void fixAfterRemoval(Node *node, Node *parent) // node (possibly nullptr) lacks one black on its path
     {
-        if(node->left != nullptr)
-            deallocTree(node->left);
+        while(node != head->left && !isRed(node))
+        {
+            if(node == parent->left)
+            {
+                Node *sibling = parent->right;  // never nullptr, its side has more black nodes
+                if(isRed(sibling))
+                {
+                    sibling->color = Color::black;
+                    parent->color = Color::red;
+                    rotateLeft(parent);
+                    sibling = parent->right;
+                }
+                if(!isRed(sibling->left) && !isRed(sibling->right))
+                {
+                    sibling->color = Color::red;
+                    node = parent;
+                    parent = node->parent;
+                    continue;
+                }
+                if(!isRed(sibling->right))
+                {
+                    sibling->left->color = Color::black;
+                    sibling->color = Color::red;
+                    rotateRight(sibling);
+                    sibling = parent->right;
+                }
+                sibling->color = parent->color;
+                parent->color = Color::black;
+                sibling->right->color = Color::black;
+                rotateLeft(parent);
+                node = head->left;
+            }
+            else
+            {
+                Node *sibling = parent->left;
+                if(isRed(sibling))
+                {
+                    sibling->color = Color::black;
+                    parent->color = Color::red;
+                    rotateRight(parent);
+                    sibling = parent->left;
+                }
+                if(!isRed(sibling->left) && !isRed(sibling->right))
+                {
+                    sibling->color = Color::red;
+                    node = parent;
+                    parent = node->parent;
+                    continue;
+                }
+                if(!isRed(sibling->left))
+                {
+                    sibling->right->color = Color::black;
+                    sibling->color = Color::red;
+                    rotateLeft(sibling);
+                    sibling = parent->left;
+                }
+                sibling->color = parent->color;
+                parent->color = Color::black;
+                sibling->left->color = Color::black;
+                rotateRight(parent);
+                node = head->left;
+            }
+        }
+        if(node != nullptr)
+            node->color = Color::black;
+    }
+
+    void cloneTree(const RedBlackTree& other) // this is empty, the shape and colors of other are reproduced in O(n)
+    {
+        if(other.size == 0)
+            return;
+
+        const Node *source = other.head->left;
+        Node *copy = createNode(*source);
+        copy->parent = head;
+        head->left = copy;
+        head->right = nullptr;
+        size = other.size;  // a partial copy is still a tree deallocNodes() can free
+
+        while(true)         // iterative pre-order walk over both trees at once
+        {
+            if(source->left != nullptr && copy->left == nullptr)
+            {
+                copy->left = createNode(*source->left);
+                copy->left->parent = copy;
+                source = source->left;
+                copy = copy->left;
+            }
+            else if(source->right != nullptr && copy->right == nullptr)
+            {
+                copy->right = createNode(*source->right);
+                copy->right->parent = copy;
+                source = source->right;
+                copy = copy->right;
+            }
+            else if(source == other.head->left)
+                break;
+            else
+            {
+                source = source->parent;
+                copy = copy->parent;
+            }
+        }
+    }
+
+    // Builds a perfectly balanced subtree of count elements taken in order from next, which is advanced.
+    // Only nodes on the deepest level of an incomplete tree are red, so every path has the same black count.
+    template <typename ForwardIterator>
+    Node * buildBalanced(ForwardIterator& next, size_type count, size_type depth, size_type redDepth)
+    {
+        if(count == 0)
+            return nullptr;
+
+        Node *left = buildBalanced(next, count / 2, depth + 1, redDepth);
+        Node *node;
+        try
+        {
+            node = createNode((*next).first, (*next).second, depth == redDepth ? Color::red : Color::black);
+        }
+        catch(...)
+        {
+            deallocSubtree(left);
+            throw;
+        }
+        node->left = left;
+        if(left != nullptr)
+            left->parent = node;
+        ++next;
+
+        try
+        {
+            node->right = buildBalanced(next, count - count / 2 - 1, depth + 1, redDepth);
+        }
+        catch(...)
+        {
+            deallocSubtree(node);   // nothing built is left behind
+            throw;
+        }
         if(node->right != nullptr)
-            deallocTree(node->right);
-        delete (node);
+            node->right->parent = node;
+        return node;
     }
 
-    void deallocTree() // remove whole tree, sentinel gets removed, too
+    void deallocSubtree(Node *top) // top and everything below it, top's parent is left alone
     {
-        if(!isEmpty())
-            deallocTree(head->left);
-        delete head;
+        if(top == nullptr)
+            return;
+
+        Node *node = top;
+        while(true) // iterative post-order, a leaf is freed and unlinked from its parent
+        {
+            if(node->left != nullptr)
+                node = node->left;
+            else if(node->right != nullptr)
+                node = node->right;
+            else if(node == top)
+            {
+                destroyNode(node);
+                return;
+            }
+            else
+            {
+                Node *parent = node->parent;
+                if(parent->left == node)
+                    parent->left = nullptr;
+                else
+                    parent->right = nullptr;
+                destroyNode(node);
+                node = parent;
+            }
+        }
     }
 
-public:
-    TreeMap()
+    void deallocNodes() // leaves head as the sentinel of an empty tree
     {
-        initTree();
+        if(size != 0)
+            deallocSubtree(head->left);
+        head->left = head;
+        head->right = head;
+        size = 0;
     }
 
-    TreeMap(std::initializer_list<value_type> list)
+    void takeNodes(RedBlackTree& other) // this is empty, other is left empty
+    {
+        if(other.size == 0)
+            return;
+
+        head->left = other.head->left;
+        head->left->parent = head;
+        head->right = nullptr;
+        size = other.size;
+        other.head->left = other.head;
+        other.head->right = other.head;
+        other.size = 0;
+    }
+
+public:
+    RedBlackTree()
     {
         initTree();
-        for(auto element : list)
-            operator[](element.first) = element.second;
     }
 
-    TreeMap(const TreeMap& other)
+    RedBlackTree(const RedBlackTree& other)
+    : allocator(NodeAllocatorTraits::select_on_container_copy_construction(other.allocator))
     {
         initTree();
-        for(auto element : other)
+        try
         {
-            operator[](element.first) = element.second;
+            cloneTree(other);
+        }
+        catch(...)
+        {
+            deallocNodes();
+            throw;
         }
     }
 
-    TreeMap(TreeMap&& other) : head(other.head), size(other.size)
+    RedBlackTree(RedBlackTree&& other) : allocator(other.allocator)
     {
-        other.head = nullptr; // make useless
-        other.size = 0;
+        initTree();
+        takeNodes(other);
     }
 
-    TreeMap& operator=(const TreeMap & other)
+    RedBlackTree& operator=(const RedBlackTree& other)
     {
         if(&other == this) // there is no sense of copying this object
             return *this;
 
-        deallocTree(); // remove current nodes
-        initTree();
+        RedBlackTree copy(other); // this tree stays untouched if copying throws
+        return *this = std::move(copy);
+    }
 
-        for(auto element : other) // copy
-        {
-            operator[](element.first) = element.second;
-        }
+    RedBlackTree& operator=(RedBlackTree&& other)
+    {
+        if(&other == this)
+            return *this;
+
+        deallocNodes(); // remove current nodes
+        allocator = other.allocator; // the nodes belong to it
+        takeNodes(other);
         return *this;
     }
 
-    TreeMap& operator=(TreeMap&& other)
+    ~RedBlackTree()
     {
-        deallocTree(); // remove current nodes
+        deallocNodes();
+    }
 
-        head = other.head; // copy
-        size = other.size;
+    size_type getSize() const
+    {
+        return size;
+    }
 
-        other.head = nullptr; // make useless
-        other.size = 0;
+    Handle endHandle() const
+    {
+        return head;
+    }
 
-        return *this;
+    Handle first() const
+    {
+        if(size == 0)
+            return head; // the map is empty
+
+        Node * leftmostNode = head->left;
+        while(leftmostNode->left != nullptr) // lowest in the left subtree is the first element
+            leftmostNode = leftmostNode->left;
+        return leftmostNode;
     }
 
-    ~TreeMap()
+    Handle next(Handle node) const
     {
-        deallocTree();
+        if(node->right != nullptr) // if there is a right subtree - find the leftmost element in there
+        {
+            node = node->right;
+            while(node->left != nullptr)
+                node = node->left;
+            return node;
+        }
+
+        Node *tmp = node->parent;
+        while(tmp != nullptr && node == tmp->right)     // there's no right subtree - find in the parent tree
+        {                                               // if we come from the left subtree, tmp is our successor
+            node = tmp;
+            tmp = tmp->parent;
+        }
+        return tmp;
     }
 
-    bool isEmpty() const
+    Handle prev(Handle node) const // the end for first(), the map must not be empty
     {
-        return size == 0;
+        if(node->left != nullptr) // left subtree is not empty - go there
+        {
+            node = node->left;
+            while(node->right != nullptr) // find the biggest element in this subtree
+                node = node->right;
+            return node;
+        }
+
+        Node *tmp = node->parent;
+        while(tmp != head && node == tmp->left) // left subtree is empty, go to the parent tree
+        {                                       // if we come from the right subtree, our parent is the predecessor
+            node = tmp;
+            tmp = tmp->parent;
+        }
+        return tmp;                             // the sentinel head if node was the leftmost
     }
 
-    mapped_type& operator[](const key_type& key)
+    const value_type& get(const Handle& node) const
     {
-        if(isEmpty())
+        return node->data;
+    }
+
+    value_type& get(const Handle& node)
+    {
+        return node->data;
+    }
+
+    template <typename LookupKey>
+    Handle find(const LookupKey& key) const // searches if key is found in the tree
+    {
+        if(size == 0)
+            return head;
+
+        Node *node = head->left;
+        while(node != nullptr)
         {
-            Node *newNode = new Node(key);
+            if(key == node->data.first)
+                return node;
+            if(key < node->data.first)
+                node = node->left;
+            else
+                node = node->right;
+        }
+        return head; // if not, end is returned
+    }
+
+    // Constructs the value from args if key is missing, key is moved in when passed as an rvalue.
+    template <typename Key, typename... Args>
+    std::pair<Handle, bool> tryEmplace(Key&& key, Args&&... args)
+    {
+        if(size == 0)
+        {
+            Node *newNode = createNode(std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                                       std::forward_as_tuple(std::forward<Args>(args)...));
             newNode->parent = head;
             head->left = newNode; // list is no longer empty
-            head->right = nullptr; // important for check against decrementing begin() in empty map
+            head->right = nullptr;
+            newNode->color = Color::black;
             size++;
-            return newNode->data.second; // return reference to the created element
+            return std::make_pair(newNode, true);
         }
 
         Node * next = head->left;
         Node * current = nullptr;
+        bool left = false;
         while(next != nullptr)
         {
             current = next;
             if(key == current->data.first)   //node with this key already exists
-            {
-                return current->data.second;
-            }
+                return std::make_pair(current, false);
 
-            if(key < current->data.first)   // if value less than the given key, go to the left subtree
+            left = key < current->data.first;
+            if(left)                        // if value less than the given key, go to the left subtree
                 next = current->left;
             else                            // else: go to the right subtree
                 next = current->right;
         }
 
-        Node * newNode = new Node(key);
+        Node * newNode = createNode(std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
         newNode->parent = current;          // current node is going to be the parent of the newly created node
-        if(key < current->data.first)
+        if(left)                            // key may have been moved into the node, so the last comparison is reused
             current->left = newNode;
         else
             current->right = newNode;
         size++;
-        return newNode->data.second;
+        fixAfterInsertion(newNode);
+        return std::make_pair(newNode, true);
     }
 
-    const mapped_type& valueOf(const key_type& key) const
+    Handle findOrInsert(const key_type& key) // inserts a value initialized value if key is missing
     {
-        if(isEmpty())
-            throw std::out_of_range("Attempt to access an element in an empty map.");
-
-        const_iterator position = find(key);
-        if(position == cend())
-            throw std::out_of_range("Attempt to access an element that is not in the map.");
-
-        return position->second;
+        return tryEmplace(key).first;
     }
 
-    mapped_type& valueOf(const key_type& key)
+    template <typename ForwardIterator>
+    void assignSorted(ForwardIterator first, size_type count) // count elements with strictly increasing keys
     {
-        if(isEmpty())
-            throw std::out_of_range("Attempt to access an element in an empty map.");
-
-        iterator position = find(key);
-        if(position == end())
-            throw std::out_of_range("Attempt to access an element that is not in the map.");
-
-        return position->second;
+        size_type depth = 0;                // of the deepest level, the root is on level 0
+        while((size_type{2} << depth) <= count)
+            depth++;
+        bool complete = count == (size_type{2} << depth) - 1;
+
+        // built aside, the current elements are only freed once nothing can throw any more
+        Node *root = buildBalanced(first, count, 0, complete || depth == 0 ? count : depth);
+        deallocNodes();
+        if(root == nullptr)
+            return;
+        root->parent = head;
+        head->left = root;
+        head->right = nullptr;
+        size = count;
     }
 
-    const_iterator find(const key_type& key) const
+    void erase(const Handle& nodeBeingRemoved)
     {
-        if(isEmpty())
-            return cend();
-        return search(head->left, key);
-    }
-
-    iterator find(const key_type& key)
-    {
-        if(isEmpty())
-            return end();
-        return search(head->left, key);
-    }
-
-    void remove(const key_type& key)
-    {
-        if(isEmpty())
-            throw std::out_of_range("Attempt to remove an element from an empty map.");
-
-        auto nodeBeingRemoved = find(key).currentNode; // which node iterator points to
-        if(nodeBeingRemoved == head)
-            throw std::out_of_range("Attempt to remove an element that is not in the map.");
-
+        Color removedColor = nodeBeingRemoved->color;   // color that disappears from the tree
+        Node *replacement;                              // node taking the place of the removed one
+        Node *replacementParent;
         if(nodeBeingRemoved->left == nullptr)                       // only one child - right
+        {
+            replacement = nodeBeingRemoved->right;
+            replacementParent = nodeBeingRemoved->parent;
             moveTree(nodeBeingRemoved, nodeBeingRemoved->right);
+        }
         else if(nodeBeingRemoved->right == nullptr)                 // only one child - left
+        {
+            replacement = nodeBeingRemoved->left;
+            replacementParent = nodeBeingRemoved->parent;
             moveTree(nodeBeingRemoved, nodeBeingRemoved->left);
+        }
         else
         {
             Node *tmp = getMinimalSubtreeNode(nodeBeingRemoved->right); // find successor - the smallest element in the right subtree
+            removedColor = tmp->color;
+            replacement = tmp->right;
+            replacementParent = tmp;
             if(tmp->parent != nodeBeingRemoved)
             {
+                replacementParent = tmp->parent;
                 moveTree(tmp, tmp->right);
                 tmp->right = nodeBeingRemoved->right;
                 tmp->right->parent = tmp;
@@ -267,39 +652,281 @@ public:
             moveTree(nodeBeingRemoved, tmp);
             tmp->left = nodeBeingRemoved->left;
             tmp->left->parent = tmp;
+            tmp->color = nodeBeingRemoved->color;           // successor takes over the removed node's color
         }
 
-        delete nodeBeingRemoved;
+        if(removedColor == Color::black && replacementParent != head)
+            fixAfterRemoval(replacement, replacementParent);
+        else if(replacement != nullptr)
+            replacement->color = Color::black;
+
+        destroyNode(nodeBeingRemoved);
         size--;
 
-        if(isEmpty())   // setup the sentinel
+        if(size == 0)   // setup the sentinel
         {
             head->right = head;
             head->left = head;
         }
     }
 
+    MemoryUsage memoryUsage() const // a node per element, the sentinel is part of the tree
+    {
+        return MemoryUsage{sizeof(*this) + size * sizeof(Node), size * sizeof(value_type)};
+    }
+};
+
+struct SortedInput // marks a range whose keys are strictly increasing
+{};
+
+constexpr SortedInput sortedInput{};
+
+struct RedBlack // default TreeMap policy
+{
+    template <typename KeyType, typename ValueType, typename Allocator>
+    using Tree = RedBlackTree<KeyType, ValueType, Allocator>;
+};
+
+template <typename KeyType, typename ValueType, typename TreePolicy = RedBlack,
+          typename Allocator = PoolAllocator<std::pair<const KeyType, ValueType>>>
+class TreeMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    class ConstIterator;
+    class Iterator;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+private:
+    using Tree = typename TreePolicy::template Tree<key_type, mapped_type, Allocator>;
+    using Handle = typename Tree::Handle;
+
+    Tree tree;
+
+    template <typename LookupKey>
+    const mapped_type& lookUp(const LookupKey& key) const
+    {
+        if(isEmpty())
+            throw std::out_of_range("Attempt to access an element in an empty map.");
+
+        auto position = tree.find(key);
+        if(position == tree.endHandle())
+            throw std::out_of_range("Attempt to access an element that is not in the map.");
+
+        return tree.get(position).second;
+    }
+
+    template <typename LookupKey>
+    void removeKey(const LookupKey& key)
+    {
+        if(isEmpty())
+            throw std::out_of_range("Attempt to remove an element from an empty map.");
+
+        auto position = tree.find(key);
+        if(position == tree.endHandle())
+            throw std::out_of_range("Attempt to remove an element that is not in the map.");
+
+        tree.erase(position);
+    }
+
+public:
+    TreeMap()
+    {}
+
+    TreeMap(std::initializer_list<value_type> list)
+    {
+        for(const auto& element : list)  // a repeated key takes the last value
+            insert_or_assign(element.first, element.second);
+    }
+
+    template <typename ForwardIterator>
+    TreeMap(SortedInput, ForwardIterator first, ForwardIterator last)
+    {
+        assignSorted(first, last);
+    }
+
+    TreeMap(const TreeMap& other)
+    : tree(other.tree)
+    {}
+
+    TreeMap(TreeMap&& other)
+    : tree(std::move(other.tree))
+    {}
+
+    TreeMap& operator=(const TreeMap & other)
+    {
+        tree = other.tree;
+        return *this;
+    }
+
+    TreeMap& operator=(TreeMap&& other)
+    {
+        tree = std::move(other.tree);
+        return *this;
+    }
+
+    ~TreeMap()
+    {}
+
+    bool isEmpty() const
+    {
+        return tree.getSize() == 0;
+    }
+
+    mapped_type& operator[](const key_type& key)
+    {
+        return tree.get(tree.findOrInsert(key)).second;
+    }
+
+    mapped_type& operator[](key_type&& key)
+    {
+        return tree.get(tree.tryEmplace(std::move(key)).first).second;
+    }
+
+    // Adds an element with the value constructed from args unless key is already present, then args are left alone.
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        auto result = tree.tryEmplace(key, std::forward<Args>(args)...);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        auto result = tree.tryEmplace(std::move(key), std::forward<Args>(args)...);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    // Adds an element constructed from args unless its key is already present. The element is built before
+    // the lookup, as its key is not known earlier, so prefer try_emplace when the key is at hand.
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type element(std::forward<Args>(args)...);
+        return try_emplace(element.first, std::move(element.second));
+    }
+
+    template <typename Value>
+    std::pair<iterator, bool> insert_or_assign(const key_type& key, Value&& value)
+    {
+        auto result = tree.tryEmplace(key, std::forward<Value>(value));
+        if(!result.second)
+            tree.get(result.first).second = std::forward<Value>(value);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    template <typename Value>
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, Value&& value)
+    {
+        auto result = tree.tryEmplace(std::move(key), std::forward<Value>(value));
+        if(!result.second)
+            tree.get(result.first).second = std::forward<Value>(value);
+        return std::make_pair(Iterator(this, result.first), result.second);
+    }
+
+    const mapped_type& valueOf(const key_type& key) const
+    {
+        return lookUp(key);
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    const mapped_type& valueOf(const LookupKey& key) const // e.g. by a StringView in a map keyed by std::string
+    {
+        return lookUp(key);
+    }
+
+    mapped_type& valueOf(const key_type& key)
+    {
+        // ugly cast, yet reduces code duplication.
+        return const_cast<mapped_type&>(lookUp(key));
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    mapped_type& valueOf(const LookupKey& key)
+    {
+        return const_cast<mapped_type&>(lookUp(key));
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        return ConstIterator(this, tree.find(key));
+    }
+
+    iterator find(const key_type& key)
+    {
+        return Iterator(this, tree.find(key));
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    const_iterator find(const LookupKey& key) const
+    {
+        return ConstIterator(this, tree.find(key));
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    iterator find(const LookupKey& key)
+    {
+        return Iterator(this, tree.find(key));
+    }
+
+    void remove(const key_type& key)
+    {
+        removeKey(key);
+    }
+
+    template <typename LookupKey, typename = EnableIfLookupKey<key_type, LookupKey>>
+    void remove(const LookupKey& key)
+    {
+        removeKey(key);
+    }
+
     void remove(const const_iterator& it)
     {
         if(it == end())
             throw std::out_of_range("Attempt to remove an element with end() iterator.");
 
-        remove(it->first); // remove node by key
+        tree.erase(it.position);
     }
 
     size_type getSize() const
     {
-        return size;
+        return tree.getSize();
+    }
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage = tree.memoryUsage();
+        usage.allocated += sizeof(*this) - sizeof(tree);
+        return usage;
+    }
+
+    // Replaces the contents with a balanced tree built in O(n), keys of the range have to be strictly increasing.
+    template <typename ForwardIterator>
+    void assignSorted(ForwardIterator first, ForwardIterator last)
+    {
+#ifndef NDEBUG
+        for(ForwardIterator it = first, previous = first; it != last; previous = it++)
+            if(it != first && !((*previous).first < (*it).first))
+                throw std::invalid_argument("Attempt to assign a range that is not sorted.");
+#endif
+        tree.assignSorted(first, static_cast<size_type>(std::distance(first, last)));
     }
 
     bool operator==(const TreeMap& other) const
     {
-        if(size != other.size)
+        if(getSize() != other.getSize())
             return false;
 
         auto otherIt = other.cbegin();
         auto ownIt = cbegin();
-        for(size_type i = 0; i < size; i++)
+        for(size_type i = 0; i < getSize(); i++)
         {
             if(!(otherIt->first == ownIt->first && otherIt->second == ownIt->second))
                 return false;
@@ -327,19 +954,12 @@ public:
 
     const_iterator cbegin() const
     {
-        if(head == head->left)
-            return ConstIterator(head); // the map is empty
-
-        Node * leftmostNode = head;
-        while(leftmostNode->left != nullptr) // lowest in the left subtree is the first element
-            leftmostNode = leftmostNode->left;
-
-        return ConstIterator(leftmostNode);
+        return ConstIterator(this, tree.first());
     }
 
     const_iterator cend() const
     {
-        return ConstIterator(head);
+        return ConstIterator(this, tree.endHandle());
     }
 
     const_iterator begin() const
@@ -351,57 +971,45 @@ public:
     {
         return cend();
     }
-
-
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename TreePolicy, typename Allocator>
+class TreeMap<KeyType, ValueType, TreePolicy, Allocator>::ConstIterator
 {
+    friend TreeMap<KeyType, ValueType, TreePolicy, Allocator>;
 public:
     using reference = typename TreeMap::const_reference;
     using iterator_category = std::bidirectional_iterator_tag;
     using value_type = typename TreeMap::value_type;
     using pointer = const typename TreeMap::value_type*;
-
-    Node *currentNode;
-
-    explicit ConstIterator()
+protected:
+    TreeMap<KeyType, ValueType, TreePolicy, Allocator> * whichMap;
+    Handle position;
+    ConstIterator(const TreeMap<KeyType, ValueType, TreePolicy, Allocator> * whichM, Handle whichP)
+    : position(whichP)
     {
-
+        whichMap = const_cast<TreeMap<KeyType, ValueType, TreePolicy, Allocator> *>(whichM);
     }
 
-    explicit ConstIterator(Node *startNode) : currentNode(startNode)
+public:
+    explicit ConstIterator()
     {
 
     }
 
-    ConstIterator(const ConstIterator& other) : currentNode(other.currentNode)
+    ConstIterator(const ConstIterator& other) : whichMap(other.whichMap), position(other.position)
     {
 
     }
 
+    ConstIterator& operator=(const ConstIterator& other) = default;
+
     ConstIterator& operator++()
     {
-        if(currentNode->parent == nullptr)
+        if(position == whichMap->tree.endHandle())
             throw std::out_of_range("Attempt to increment end() iterator.");
 
-        if(currentNode->right != nullptr) // if there is a right subtree - find the leftmost element in there
-        {
-            currentNode = currentNode->right;
-            while(currentNode->left != nullptr)
-                currentNode = currentNode->left;
-            return *this;
-        }
-
-        Node *tmp = currentNode->parent;
-        while(tmp != nullptr && currentNode == tmp->right)      // there's no right subtree - find in the parent tree
-        {                                                       // if we come from the left subtree, tmp is our successor
-            currentNode = tmp;
-            tmp = tmp->parent;
-        }
-
-        currentNode = tmp;
+        position = whichMap->tree.next(position);
         return *this;
     }
 
@@ -414,28 +1022,13 @@ public:
 
     ConstIterator& operator--()
     {
-        if(currentNode->right == currentNode) // the sentinel is used here
+        if(whichMap->isEmpty())
             throw std::out_of_range("Attempt to decrement begin() iterator in an empty map.");
+        auto previous = whichMap->tree.prev(position);
+        if(previous == whichMap->tree.endHandle())
+            throw std::out_of_range("Attempt to decrement begin() iterator.");
 
-        if(currentNode->left != nullptr) // left subtree is not empty - go there
-        {
-            currentNode = currentNode->left;
-            while(currentNode->right != nullptr) // find the biggest element in this subtree
-                currentNode = currentNode->right;
-            return *this;
-        }
-
-        Node *tmp = currentNode->parent;
-        while(tmp != nullptr && currentNode == tmp->left)   // left subtree is empty, go to the parent tree
-        {                                                   // if we come from the right subtree, our parent is the predecessor
-            if(tmp->parent == nullptr)
-                throw std::out_of_range("Attempt to decrement begin() iterator.");
-
-            currentNode = tmp;
-            tmp = tmp->parent;
-        }
-
-        currentNode = tmp;
+        position = previous;
         return *this;
     }
 
@@ -448,9 +1041,9 @@ public:
 
     reference operator*() const
     {
-        if(currentNode->right == currentNode) // tree is empty, sentinel is used here
-            throw std::out_of_range("Attempt to dereference in an empty tree.");
-        return currentNode->data;
+        if(position == whichMap->tree.endHandle())
+            throw std::out_of_range("Attempt to dereference end() iterator.");
+        return whichMap->tree.get(position);
     }
 
     pointer operator->() const
@@ -460,7 +1053,7 @@ public:
 
     bool operator==(const ConstIterator& other) const
     {
-        return this->currentNode == other.currentNode;
+        return whichMap == other.whichMap && position == other.position;
     }
 
     bool operator!=(const ConstIterator& other) const
@@ -469,13 +1062,20 @@ public:
     }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::Iterator : public TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename TreePolicy, typename Allocator>
+class TreeMap<KeyType, ValueType, TreePolicy, Allocator>::Iterator : public TreeMap<KeyType, ValueType, TreePolicy, Allocator>::ConstIterator
 {
+    friend TreeMap<KeyType, ValueType, TreePolicy, Allocator>;
 public:
     using reference = typename TreeMap::reference;
     using pointer = typename TreeMap::value_type*;
+protected:
+    Iterator(TreeMap<KeyType, ValueType, TreePolicy, Allocator> * whichM, Handle whichP)
+    : ConstIterator(whichM, whichP)
+    {
 
+    }
+public:
     explicit Iterator()
     {
 
@@ -0,0 +1,164 @@
+#ifndef AISDI_MAPS_WORKLOADS_H
+#define AISDI_MAPS_WORKLOADS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Hashing.h"
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+// Key streams for the benchmark. Every generator is deterministic for a given count and seed.
+using Keys = std::vector<int>;
+
+inline Keys uniformKeys(std::size_t count, std::uint64_t seed) // over the whole int range
+{
+    std::mt19937_64 generator(seed);
+    std::uniform_int_distribution<int> distribution(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+    Keys keys(count);
+    for(auto& key : keys)
+        key = distribution(generator);
+    return keys;
+}
+
+inline Keys sequentialKeys(std::size_t count, std::uint64_t) // 0, 1, 2, ...
+{
+    Keys keys(count);
+    for(std::size_t i = 0; i < count; i++)
+        keys[i] = static_cast<int>(i);
+    return keys;
+}
+
+inline Keys reverseSequentialKeys(std::size_t count, std::uint64_t) // ..., 2, 1, 0
+{
+    Keys keys(count);
+    for(std::size_t i = 0; i < count; i++)
+        keys[i] = static_cast<int>(count - 1 - i);
+    return keys;
+}
+
+// Runs of clusterSize consecutive keys, each run starting at a random key.
+inline Keys clusteredKeys(std::size_t count, std::uint64_t seed, std::size_t clusterSize = 64)
+{
+    std::mt19937_64 generator(seed);
+    std::uniform_int_distribution<int> start(std::numeric_limits<int>::min(),
+                                             std::numeric_limits<int>::max() - static_cast<int>(clusterSize));
+    Keys keys;
+    keys.reserve(count);
+    while(keys.size() < count)
+    {
+        int first = start(generator);
+        for(std::size_t i = 0; i < clusterSize && keys.size() < count; i++)
+            keys.push_back(first + static_cast<int>(i));
+    }
+    return keys;
+}
+
+// Ranks from a Zipf distribution over count items (rank r drawn with probability proportional to 1 / r^exponent),
+// generated as in Gray et al., "Quickly generating billion-record synthetic databases".
+// Ranks are scrambled into keys, so the popular ones are spread over the key range instead of being adjacent.
+inline Keys zipfianKeys(std::size_t count, std::uint64_t seed, double exponent = 0.99)
+{
+    if(!(exponent > 0.0 && exponent < 1.0))
+        throw std::invalid_argument("Zipfian exponent has to be in (0, 1).");
+
+    Keys keys(count);
+    if(count == 0)
+        return keys;
+
+    double items = static_cast<double>(count);
+    double zetaItems = 0.0;
+    for(std::size_t i = 1; i <= count; i++)
+        zetaItems += 1.0 / std::pow(static_cast<double>(i), exponent);
+    double zetaTwo = 1.0 + 1.0 / std::pow(2.0, exponent);
+    double alpha = 1.0 / (1.0 - exponent);
+    double eta = (1.0 - std::pow(2.0 / items, 1.0 - exponent)) / (1.0 - zetaTwo / zetaItems);
+
+    std::mt19937_64 generator(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for(auto& key : keys)
+    {
+        double u = uniform(generator);
+        double uz = u * zetaItems;
+        std::uint64_t rank;
+        if(uz < 1.0)
+            rank = 0;
+        else if(uz < zetaTwo)
+            rank = 1;
+        else
+            rank = std::min(static_cast<std::uint64_t>(items * std::pow(eta * u - eta + 1.0, alpha)),
+                            static_cast<std::uint64_t>(count - 1));
+        key = static_cast<int>(static_cast<std::uint32_t>(mixHashBits(rank ^ seed)));
+    }
+    return keys;
+}
+
+// Distinct keys whose default hashes, as HashMap<int, ...> computes them, agree in their lowest sharedBits
+// bits. Tables with up to 2^sharedBits buckets put all of them in one bucket, bigger ones in one of every
+// 2^sharedBits buckets, and Swiss tables in one of every 2^(sharedBits - 7) groups with equal fingerprints.
+// Consecutive ints from a seeded start are tested against the hash, about 2^sharedBits per key.
+inline Keys sameBucketKeys(std::size_t count, std::uint64_t seed)
+{
+    enum : std::uint64_t
+    {
+        sharedBits = 10
+    };
+    const std::size_t mask = (std::size_t{1} << sharedBits) - 1;
+    if(count > (std::numeric_limits<std::uint32_t>::max() >> sharedBits))
+        throw std::invalid_argument("Too many keys sharing a bucket requested: " + std::to_string(count));
+
+    std::uint32_t candidate = static_cast<std::uint32_t>(mixHashBits(seed));
+    Keys keys;
+    keys.reserve(count);
+    for(; keys.size() < count; candidate++)
+    {
+        int key = static_cast<int>(candidate);
+        if((spreadHash<Hash<int>>(key) & mask) == 0)
+            keys.push_back(key);
+    }
+    return keys;
+}
+
+struct Distribution
+{
+    std::string name;
+    Keys (*generate)(std::size_t count, std::uint64_t seed);
+    std::size_t maxSize;    // bigger sizes are skipped, e.g. where they make a container quadratic
+};
+
+inline Keys defaultZipfianKeys(std::size_t count, std::uint64_t seed)
+{
+    return zipfianKeys(count, seed);
+}
+
+inline Keys defaultClusteredKeys(std::size_t count, std::uint64_t seed)
+{
+    return clusteredKeys(count, seed);
+}
+
+inline std::vector<Distribution> distributions()
+{
+    const auto unlimited = std::numeric_limits<std::size_t>::max();
+    return {
+        { "uniform", uniformKeys, unlimited },
+        { "zipfian", defaultZipfianKeys, unlimited },
+        { "sequential", sequentialKeys, unlimited },
+        { "reverse", reverseSequentialKeys, unlimited },
+        { "clustered", defaultClusteredKeys, unlimited },
+        { "same-bucket", sameBucketKeys, 10000 }   // chains grow with the size, bigger ones take too long
+    };
+}
+
+}
+}
+
+#endif /* AISDI_MAPS_WORKLOADS_H */
@@ -1,13 +1,42 @@
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
-#include <string>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <random>
-#include <iostream>
-#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "Benchmark.h"
+#include "BenchmarkReport.h"
+#include "Workloads.h"
 #include "TreeMap.h"
 #include "HashMap.h"
+#include "ConcurrentHashMap.h"
+#include "ReadMostlyHashMap.h"
+#include "ConcurrentTreeMap.h"
+
+// Every heap allocation of the benchmark is counted, the array and nothrow forms end up here as well.
+// Kept out of line, inlined into library code GCC takes the free() below for a mismatched deallocation.
+__attribute__((noinline)) void * operator new(std::size_t size)
+{
+    aisdi::benchmark::countAllocation(size);
+    if(void *allocated = std::malloc(size == 0 ? 1 : size))
+        return allocated;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
 
 namespace
 {
@@ -15,134 +44,495 @@ namespace
 using string = std::string;
 using HashMap = aisdi::HashMap<int, string>;
 using TreeMap = aisdi::TreeMap<int, string>;
+using ConcurrentHashMap = aisdi::ConcurrentHashMap<int, string>;
+using ReadMostlyHashMap = aisdi::ReadMostlyHashMap<int, string>;
+using ConcurrentTreeMap = aisdi::ConcurrentTreeMap<int, string>;
+using aisdi::benchmark::Case;
+using aisdi::benchmark::Counts;
+using aisdi::benchmark::Distribution;
+using aisdi::benchmark::Keys;
+using aisdi::benchmark::Timer;
+using aisdi::benchmark::doNotOptimize;
+
 const string testString = "dummy value";
 
-void performTreeMapInsertingTest(size_t howManyInserts)
+template <typename Type>
+class Lazy // built by the factory on the first get(), dropped by reset(), copies share the value
+{
+    std::shared_ptr<std::unique_ptr<Type>> value;
+    std::function<Type*()> factory;
+
+public:
+    explicit Lazy(std::function<Type*()> factory)
+    : value(std::make_shared<std::unique_ptr<Type>>()), factory(factory)
+    {}
+
+    Type& get() const
+    {
+        if(!*value)
+            value->reset(factory());
+        return **value;
+    }
+
+    void reset() const
+    {
+        value->reset();
+    }
+};
+
+struct Workload
 {
-    std::default_random_engine generator;
-    std::normal_distribution<double> distribution(0,50000);
+    Keys inserted;      // in generation order, may repeat
+    Keys present;       // distinct inserted keys, shuffled
+    Keys missing;       // as many keys that were never inserted, shuffled
+};
 
-    TreeMap map;
-    std::chrono::time_point<std::chrono::system_clock> start, end;
-    std::cout << "HashMap\t\tInsert\t\t" << howManyInserts << "\t\t";
+Workload * makeWorkload(const Distribution& distribution, std::size_t size, std::uint64_t seed)
+{
+    std::unique_ptr<Workload> workload(new Workload);
+    workload->inserted = distribution.generate(size, seed);
 
-    start = std::chrono::system_clock::now();
-    for (size_t i = 0; i< howManyInserts; ++i)
+    Keys sorted = workload->inserted;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    std::mt19937_64 generator(seed + 1);
+    std::uniform_int_distribution<int> anyKey;
+    while(workload->missing.size() < sorted.size())
     {
-        int number = distribution(generator);
-        map[number] = testString;
+        int key = anyKey(generator);
+        if(!std::binary_search(sorted.begin(), sorted.end(), key))
+            workload->missing.push_back(key);
     }
-    end = std::chrono::system_clock::now();
 
-    std::chrono::duration<double> timeTaken = end-start;
-    std::cout << timeTaken.count() << "s\n";
+    workload->present = std::move(sorted);
+    std::shuffle(workload->present.begin(), workload->present.end(), generator);
+    return workload.release();
 }
 
-void performHashMapInsertingTest(size_t howManyInserts)
+enum class Operation : unsigned char
 {
-    std::default_random_engine generator;
-    std::normal_distribution<double> distribution(0,50000);
+    read,
+    insert,
+    remove
+};
 
-    HashMap map;
-    std::chrono::time_point<std::chrono::system_clock> start, end;
-    std::cout << "TreeMap\t\tInsert\t\t" << howManyInserts << "\t\t";
+using Script = std::vector<std::pair<Operation, int>>;
 
-    start = std::chrono::system_clock::now();
-    for (size_t i = 0; i< howManyInserts; ++i)
+// As many operations as there are distinct keys, writes alternate between inserting a missing key
+// and removing a present one, so the map keeps its size. Reads look up keys present at that moment.
+Script * makeMixScript(const Workload& workload, unsigned readPercent, std::uint64_t seed)
+{
+    std::unique_ptr<Script> script(new Script);
+    Keys live = workload.present;
+    std::size_t nextMissing = 0;
+    bool insertNext = true;
+    std::mt19937_64 generator(seed + 2);
+
+    for(std::size_t i = 0; i < workload.present.size(); i++)
     {
-        int number = distribution(generator);
-        map[number] = testString;
+        if(generator() % 100 < readPercent)
+            script->emplace_back(Operation::read, live[generator() % live.size()]);
+        else if(insertNext)
+        {
+            live.push_back(workload.missing[nextMissing++]);
+            script->emplace_back(Operation::insert, live.back());
+            insertNext = false;
+        }
+        else
+        {
+            std::swap(live[generator() % live.size()], live.back());
+            script->emplace_back(Operation::remove, live.back());
+            live.pop_back();
+            insertNext = true;
+        }
     }
-    end = std::chrono::system_clock::now();
+    return script.release();
+}
 
-    std::chrono::duration<double> timeTaken = end-start;
-    std::cout << timeTaken.count() << "s\n";
-}
+template <typename Map>
+void fill(Map& map, const Keys& keys)
+{
+    for(int key : keys)
+        map[key] = testString;
+}
 
-void performTreeMapIterationTest(size_t howManyElements)
+template <typename Map>
+std::size_t countFound(const Map& map, const Keys& keys)
 {
-    std::default_random_engine generator;
-    std::normal_distribution<double> distribution(0,50000);
+    std::size_t found = 0;
+    for(int key : keys)
+        found += map.find(key) != map.end();
+    return found;
+}
 
-    TreeMap map;
-    std::chrono::time_point<std::chrono::system_clock> start, end;
-    std::cout << "HashMap\t\tIterate\t\t" << howManyElements << "\t\t";
+template <typename Map>
+void addCases(std::vector<Case>& cases, const string& container, const Distribution& distribution, std::size_t size,
+              std::uint64_t seed)
+{
+    const string suffix = "/" + distribution.name + "/" + std::to_string(size);
+    Lazy<Workload> workload([distribution, size, seed]() { return makeWorkload(distribution, size, seed); });
+    Lazy<Map> filled([workload]()
+    {
+        std::unique_ptr<Map> map(new Map);
+        fill(*map, workload.get().inserted);
+        return map.release();
+    });
+    Lazy<Script> mix95([workload, seed]() { return makeMixScript(workload.get(), 95, seed); });
+    Lazy<Script> mix50([workload, seed]() { return makeMixScript(workload.get(), 50, seed); });
+    auto release = [workload, filled, mix95, mix50]()
+    {
+        mix95.reset();
+        mix50.reset();
+        filled.reset();
+        workload.reset();
+    };
 
-	for (size_t i = 0; i< howManyElements; ++i)
+    cases.push_back(Case{container + "/insert" + suffix, [workload](Timer& timer)
     {
-        int number = distribution(generator);
-        map[number] = testString;
+        const Keys& keys = workload.get().inserted;
+        Map map;
+        timer.start();
+        fill(map, keys);
+        timer.stop();
+        return Counts(keys.size(), map.getSize(), map.memoryUsage().allocated);
+    }, release});
+
+    cases.push_back(Case{container + "/iterate" + suffix, [filled](Timer& timer)
+    {
+        const Map& map = filled.get();
+        std::size_t sum = 0;
+        timer.start();
+        for(const auto& element : map)
+            sum += static_cast<std::size_t>(element.first) + element.second.size();
+        timer.stop();
+        doNotOptimize(sum);
+        return Counts(map.getSize(), map.getSize());
+    }, release});
+
+    cases.push_back(Case{container + "/find-hit" + suffix, [workload, filled](Timer& timer)
+    {
+        const Map& map = filled.get();
+        const Keys& keys = workload.get().present;
+        timer.start();
+        std::size_t found = countFound(map, keys);
+        timer.stop();
+        if(found != keys.size())
+            throw std::logic_error("A present key was not found in " + std::to_string(keys.size()) + " lookups.");
+        return Counts(keys.size(), keys.size());
+    }, release});
+
+    cases.push_back(Case{container + "/find-miss" + suffix, [workload, filled](Timer& timer)
+    {
+        const Map& map = filled.get();
+        const Keys& keys = workload.get().missing;
+        timer.start();
+        std::size_t found = countFound(map, keys);
+        timer.stop();
+        if(found != 0)
+            throw std::logic_error("A missing key was found.");
+        return Counts(keys.size(), map.getSize());
+    }, release});
+
+    cases.push_back(Case{container + "/valueOf" + suffix, [workload, filled](Timer& timer)
+    {
+        const Map& map = filled.get();
+        const Keys& keys = workload.get().present;
+        std::size_t sum = 0;
+        timer.start();
+        for(int key : keys)
+            sum += map.valueOf(key).size();
+        timer.stop();
+        doNotOptimize(sum);
+        return Counts(keys.size(), keys.size());
+    }, release});
+
+    cases.push_back(Case{container + "/remove" + suffix, [workload](Timer& timer)
+    {
+        const Workload& keys = workload.get();
+        Map map;
+        fill(map, keys.inserted);
+        timer.start();
+        for(int key : keys.present)
+            map.remove(key);
+        timer.stop();
+        doNotOptimize(map.getSize());
+        return Counts(keys.present.size(), keys.present.size());
+    }, release});
+
+    for(const auto& mix : { std::make_pair(string("mix-95-5"), mix95), std::make_pair(string("mix-50-50"), mix50) })
+    {
+        Lazy<Script> script = mix.second;
+        cases.push_back(Case{container + "/" + mix.first + suffix, [workload, script](Timer& timer)
+        {
+            const Script& operations = script.get();
+            Map map;
+            fill(map, workload.get().inserted);
+            std::size_t found = 0;
+            timer.start();
+            for(const auto& operation : operations)
+                switch(operation.first)
+                {
+                case Operation::read:
+                    found += map.find(operation.second) != map.end();
+                    break;
+                case Operation::insert:
+                    map[operation.second] = testString;
+                    break;
+                case Operation::remove:
+                    map.remove(operation.second);
+                    break;
+                }
+            timer.stop();
+            doNotOptimize(found);
+            return Counts(operations.size(), workload.get().present.size());
+        }, release});
     }
-    start = std::chrono::system_clock::now();
-    for(auto elem: map)
+}
+
+// One mutex around a whole map, the usual way of sharing one, for the concurrent maps to be compared with.
+template <typename Map>
+class LockedMap
+{
+    mutable std::mutex mutex;
+    Map map;
+
+public:
+    bool find(int key, string& value) const
     {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = map.find(key);
+        if(it == map.end())
+            return false;
+        value = it->second;
+        return true;
+    }
 
-	}
-    end = std::chrono::system_clock::now();
+    bool insert_or_assign(int key, const string& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return map.insert_or_assign(key, value).second;
+    }
 
-    std::chrono::duration<double> timeTaken = end-start;
-    std::cout << timeTaken.count() << "s\n";
+    bool erase(int key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = map.find(key);
+        if(it == map.end())
+            return false;
+        map.remove(it);
+        return true;
+    }
+};
+
+using LockedHashMap = LockedMap<HashMap>;
+using LockedTreeMap = LockedMap<TreeMap>;
+
+template <typename Map>
+bool removeKey(Map& map, int key)
+{
+    return map.erase(key);
 }
 
-void performHashMapIterationTest(size_t howManyElements)
+bool removeKey(ConcurrentTreeMap& map, int key) // named after TreeMap::remove
 {
-    std::default_random_engine generator;
-    std::normal_distribution<double> distribution(0,50000);
+    return map.remove(key);
+}
+
+using Scripts = std::vector<Script>;
 
-    HashMap map;
-    std::chrono::time_point<std::chrono::system_clock> start, end;
-    std::cout << "TreeMap\t\tIterate\t\t" << howManyElements << "\t\t";
+const std::size_t operationsPerThread = 20000;
 
-	for (size_t i = 0; i< howManyElements; ++i)
+// A script per thread. Reads draw keys as the distribution inserted them, so popular keys are read more often,
+// writes insert or erase keys that were never inserted otherwise, so the map keeps about its size.
+Scripts * makeThreadScripts(const Workload& workload, std::size_t threads, std::uint64_t seed)
+{
+    std::unique_ptr<Scripts> scripts(new Scripts(threads));
+    for(std::size_t t = 0; t < threads; t++)
     {
-        int number = distribution(generator);
-        map[number] = testString;
+        std::mt19937_64 generator(seed + 3 + t);
+        Script& script = (*scripts)[t];
+        for(std::size_t i = 0; i < operationsPerThread; i++)
+        {
+            if(generator() % 100 < 95)
+                script.emplace_back(Operation::read, workload.inserted[generator() % workload.inserted.size()]);
+            else
+                script.emplace_back(generator() % 2 == 0 ? Operation::insert : Operation::remove,
+                                    workload.missing[generator() % workload.missing.size()]);
+        }
     }
-    start = std::chrono::system_clock::now();
-    for(auto elem: map)
+    return scripts.release();
+}
+
+// The threads are started before the timer and released at once, the timer stops when the last one is done.
+// Hardware counters only follow the timing thread, which just waits meanwhile.
+template <typename Map>
+std::size_t runThreads(Map& map, const Scripts& scripts, Timer& timer)
+{
+    std::atomic<bool> released(false);
+    std::atomic<std::size_t> waiting(0);
+    std::vector<std::size_t> found(scripts.size(), 0);
+    std::vector<std::thread> threads;
+    for(std::size_t t = 0; t < scripts.size(); t++)
+        threads.emplace_back([&map, &scripts, &found, &released, &waiting, t]()
+        {
+            waiting++;
+            while(!released.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            string value;
+            std::size_t hits = 0;
+            for(const auto& operation : scripts[t])
+                switch(operation.first)
+                {
+                case Operation::read:
+                    hits += map.find(operation.second, value);
+                    break;
+                case Operation::insert:
+                    map.insert_or_assign(operation.second, testString);
+                    break;
+                case Operation::remove:
+                    removeKey(map, operation.second);
+                    break;
+                }
+            found[t] = hits;
+        });
+
+    while(waiting.load() != scripts.size())
+        std::this_thread::yield();
+    timer.start();
+    released.store(true, std::memory_order_release);
+    for(auto& thread : threads)
+        thread.join();
+    timer.stop();
+
+    std::size_t total = 0;
+    for(std::size_t hits : found)
+        total += hits;
+    return total;
+}
+
+template <typename Map>
+void addConcurrentCases(std::vector<Case>& cases, const string& container, const Distribution& distribution,
+                        std::size_t size, std::uint64_t seed)
+{
+    const string suffix = "/" + distribution.name + "/" + std::to_string(size);
+    Lazy<Workload> workload([distribution, size, seed]() { return makeWorkload(distribution, size, seed); });
+    Lazy<Map> filled([workload]()
     {
+        std::unique_ptr<Map> map(new Map);
+        for(int key : workload.get().inserted)
+            map->insert_or_assign(key, testString);
+        return map.release();
+    });
 
-	}
-    end = std::chrono::system_clock::now();
+    for(std::size_t threads : { 1, 2, 4, 8, 16, 32, 64 })
+    {
+        Lazy<Scripts> scripts([workload, threads, seed]() { return makeThreadScripts(workload.get(), threads, seed); });
+        auto release = [workload, filled, scripts]()
+        {
+            scripts.reset();
+            filled.reset();
+            workload.reset();
+        };
 
-    std::chrono::duration<double> timeTaken = end-start;
-    std::cout << timeTaken.count() << "s\n";
+        // ns/op falls with the thread count as long as the threads do not wait for each other
+        cases.push_back(Case{container + "/mix-95-5-threads-" + std::to_string(threads) + suffix,
+                             [workload, filled, scripts](Timer& timer)
+        {
+            const Scripts& operations = scripts.get();
+            std::size_t found = runThreads(filled.get(), operations, timer);
+            doNotOptimize(found);
+            return Counts(operations.size() * operationsPerThread, workload.get().present.size());
+        }, release});
+    }
 }
 
-void line(size_t width = 64)
+std::vector<Case> makeCases(std::uint64_t seed)
 {
-    for(size_t i = 0; i < width; i++)
-        std::cout << '=';
-    std::cout << '\n';
+    const std::vector<std::size_t> sizes = { 1000, 10000, 100000, 1000000, 10000000 };
+
+    std::vector<Case> cases;
+    for(const auto& distribution : aisdi::benchmark::distributions())
+        for(std::size_t size : sizes)
+            if(size <= distribution.maxSize)
+            {
+                addCases<TreeMap>(cases, "TreeMap", distribution, size, seed);
+                addCases<HashMap>(cases, "HashMap", distribution, size, seed);
+            }
+
+    for(const auto& distribution : aisdi::benchmark::distributions())
+        if(distribution.name == "uniform" || distribution.name == "zipfian")   // zipfian keeps threads on hot shards
+        {
+            addConcurrentCases<ConcurrentHashMap>(cases, "ConcurrentHashMap", distribution, 100000, seed);
+            addConcurrentCases<ReadMostlyHashMap>(cases, "ReadMostlyHashMap", distribution, 100000, seed);
+            addConcurrentCases<LockedHashMap>(cases, "LockedHashMap", distribution, 100000, seed);
+            addConcurrentCases<ConcurrentTreeMap>(cases, "ConcurrentTreeMap", distribution, 100000, seed);
+            addConcurrentCases<LockedTreeMap>(cases, "LockedTreeMap", distribution, 100000, seed);
+        }
+    return cases;
 }
 
 } // namespace
 
-int main()
-{
-    line();
-    std::cout << "\tTime tests for TreeMap and HashMap\n";
-    std::cout << "\tNormal distribution is used to generate keys\n";
-    line();
-    std::cout << "Variant:\tOperation:\tCount:\t\tTime taken:\n";
-    line(); // names were swapped accidentally
-    performTreeMapInsertingTest(100);
-    performHashMapInsertingTest(100);
-    line();
-    performTreeMapInsertingTest(1000);
-    performHashMapInsertingTest(1000);
-    line();
-    performTreeMapInsertingTest(10000);
-    performHashMapInsertingTest(10000);
-    line();
-    performTreeMapIterationTest(100);
-    performHashMapIterationTest(100);
-    line();
-    performTreeMapIterationTest(1000);
-    performHashMapIterationTest(1000);
-    line();
-    performTreeMapIterationTest(10000);
-    performHashMapIterationTest(10000);
-    line();
+int main(int argc, char *argv[])
+{
+    namespace benchmark = aisdi::benchmark;
+    benchmark::Options options;
+    try
+    {
+        options = benchmark::parseOptions(argc, argv);
+    }
+    catch(const std::invalid_argument& error)
+    {
+        std::cerr << error.what() << '\n'
+                  << "Usage: " << argv[0] << " [--filter=PATTERN[$][,PATTERN[$]...]] [--repetitions=N] [--warmup=N]"
+                  << " [--seed=N] [--list] [--format=text|json|csv] [--baseline=RESULTS.csv] [--threshold=PERCENT]"
+                  << " [--significance=P] [--counters]\n";
+        return 1;
+    }
+
+    std::vector<benchmark::Result> baseline;
+    try
+    {
+        if(!options.baseline.empty())
+            baseline = benchmark::loadResults(options.baseline);
+    }
+    catch(const std::runtime_error& error)
+    {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    std::unique_ptr<benchmark::PerfCounters> counters;
+    if(options.counters && !options.listOnly)
+    {
+        counters.reset(new benchmark::PerfCounters);
+        if(!counters->getUnavailable().empty())
+        {
+            std::cerr << "Unavailable hardware counters:";
+            for(const auto& name : counters->getUnavailable())
+                std::cerr << ' ' << name;
+            std::cerr << " (" << counters->getReason() << ")\n";
+        }
+        if(counters->names().empty())
+        {
+            std::cerr << "Measuring time only.\n";
+            counters.reset();
+        }
+    }
+
+    auto results = benchmark::runCases(makeCases(options.seed), options, std::cout, counters.get());
+    if(options.baseline.empty() || options.listOnly)
+        return 0;
+
+    // Keeps the standard output parseable for the machine readable formats.
+    std::ostream& report = options.format == benchmark::Format::text ? std::cout : std::cerr;
+    auto comparisons = benchmark::compare(baseline, results, options);
+    report << '\n';
+    benchmark::printComparisons(report, comparisons);
+    for(const auto& comparison : comparisons)
+        if(comparison.verdict == benchmark::Verdict::regression)
+            return 2;
     return 0;
 }
@@ -0,0 +1,74 @@
+#include <BenchmarkReport.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using aisdi::benchmark::Format;
+using aisdi::benchmark::Result;
+
+BOOST_AUTO_TEST_SUITE(BenchmarkReportTests)
+
+BOOST_AUTO_TEST_CASE(GivenResultWithCounters_WhenWrittenAsCsvAndLoaded_ThenEverythingComesBack)
+{
+  Result written{};
+  written.name = "HashMap/find-hit/uniform/1000";
+  written.operations = 1000;
+  written.distinctKeys = 999;
+  written.samples = { 1500, 1200, 1300 };
+  written.time = aisdi::benchmark::summarize(written.samples);
+  written.counters = { { "cycles", 42.5 }, { "cache-misses", 0.25 } };
+  written.allocations = { 7, 448 };
+  written.peakResident = 1 << 20;
+  written.containerBytes = 32768;
+
+  const std::string fileName = "BenchmarkReportTests.csv";
+  {
+    std::ofstream out(fileName);
+    aisdi::benchmark::printHeader(out, Format::csv);
+    aisdi::benchmark::printResult(out, written, Format::csv, true);
+  }
+  std::vector<Result> loaded = aisdi::benchmark::loadResults(fileName);
+  std::remove(fileName.c_str());
+
+  BOOST_REQUIRE_EQUAL(loaded.size(), 1);
+  const Result& result = loaded.front();
+  BOOST_CHECK_EQUAL(result.name, written.name);
+  BOOST_CHECK_EQUAL(result.operations, written.operations);
+  BOOST_CHECK_EQUAL(result.distinctKeys, written.distinctKeys);
+  BOOST_CHECK(result.samples == written.samples);
+  BOOST_CHECK_EQUAL(result.time.median, written.time.median);
+  BOOST_REQUIRE_EQUAL(result.counters.size(), 2);
+  BOOST_CHECK_EQUAL(result.counters[0].first, "cycles");
+  BOOST_CHECK_CLOSE(result.counters[0].second, 42.5, 0.01);
+  BOOST_CHECK_EQUAL(result.counters[1].first, "cache-misses");
+  BOOST_CHECK_CLOSE(result.counters[1].second, 0.25, 0.01);
+  BOOST_CHECK_EQUAL(result.allocations.count, 7);
+  BOOST_CHECK_EQUAL(result.allocations.bytes, 448);
+  BOOST_CHECK_EQUAL(result.peakResident, written.peakResident);
+  BOOST_CHECK_EQUAL(result.containerBytes, written.containerBytes);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCsvWithMissingColumnsOrBadNumbers_WhenLoaded_ThenExceptionIsThrown)
+{
+  const std::string fileName = "BenchmarkReportTests.csv";
+  const std::string header = "name,distinct keys,operations,min,median,max,mean,stddev,ns/op,samples,counters,"
+                             "allocations,allocated bytes,peak resident,container bytes\n";
+  for (const std::string row : { "Map/find/1000,999,1000,1,1,1,1,0,1,1300,cycles=1\n",
+                                 "Map/find/1000,999,1000,1,1,1,1,0,1,1300,,7,448,0,-1\n",
+                                 "Map/find/1000,999,many,1,1,1,1,0,1,1300,,7,448,0,0\n" })
+  {
+    {
+      std::ofstream out(fileName);
+      out << header << row;
+    }
+    BOOST_CHECK_THROW(aisdi::benchmark::loadResults(fileName), std::runtime_error);
+  }
+  std::remove(fileName.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,165 @@
+#include <ConcurrentHashMap.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+// Boost.Test assertions are not thread safe, threads only record what they saw and the test checks it afterwards.
+using Map = aisdi::ConcurrentHashMap<std::int32_t, std::string>;
+
+BOOST_AUTO_TEST_SUITE(ConcurrentHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenShardCount_WhenCreatingMap_ThenItIsRoundedUpToPowerOfTwo)
+{
+  BOOST_CHECK_EQUAL(Map(1).shard_count(), 1);
+  BOOST_CHECK_EQUAL(Map(5).shard_count(), 8);
+  BOOST_CHECK_EQUAL(Map(64).shard_count(), 64);
+  BOOST_CHECK_THROW(Map(100000), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenUsedFromOneThread_ThenItBehavesAsHashMap)
+{
+  Map map(8);
+  BOOST_CHECK(map.isEmpty());
+
+  BOOST_CHECK(map.insert_or_assign(1, "one"));
+  BOOST_CHECK(!map.insert_or_assign(1, "uno"));
+  BOOST_CHECK(map.try_emplace(2, 3, 'b'));
+  BOOST_CHECK(!map.try_emplace(2, "ignored"));
+
+  std::string value;
+  BOOST_CHECK(map.find(1, value));
+  BOOST_CHECK_EQUAL(value, "uno");
+  BOOST_CHECK_EQUAL(map.valueOf(2), "bbb");
+  BOOST_CHECK(!map.find(3, value));
+  BOOST_CHECK_THROW(map.valueOf(3), std::out_of_range);
+
+  BOOST_CHECK_EQUAL(map.compute(3, [](std::string& v) { v += "!"; return v.size(); }), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(3), "!");
+
+  BOOST_CHECK(map.erase(1));
+  BOOST_CHECK(!map.erase(1));
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithItems_WhenVisitingEach_ThenEveryItemIsVisitedOnce)
+{
+  Map map(16);
+  std::map<std::int32_t, std::string> expected;
+  for (std::int32_t i = 0; i < 1000; ++i)
+  {
+    map.insert_or_assign(i, std::to_string(i));
+    expected[i] = std::to_string(i);
+  }
+
+  std::map<std::int32_t, std::string> visited;
+  map.for_each([&](const Map::value_type& item) { BOOST_CHECK(visited.insert(item).second); });
+
+  BOOST_CHECK(visited == expected);
+  BOOST_CHECK_EQUAL(map.memoryUsage().payload, 1000 * sizeof(Map::value_type));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenComputingOnSharedKeys_ThenNoUpdateIsLost)
+{
+  aisdi::ConcurrentHashMap<std::int32_t, std::int64_t> map(4);
+  const int threadCount = 8;
+  const int rounds = 20000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; ++t)
+    threads.emplace_back([&map, t]()
+    {
+      for (int i = 0; i < rounds; ++i)
+        map.compute((i + t) % 16, [](std::int64_t& value) { ++value; });
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  std::int64_t total = 0;
+  for (std::int32_t key = 0; key < 16; ++key)
+    total += map.valueOf(key);
+  BOOST_CHECK_EQUAL(total, threadCount * rounds);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenInsertingAndErasingOwnKeys_ThenEachSeesOnlyItsOwnChanges)
+{
+  Map map(8);
+  const int threadCount = 8;
+  const std::int32_t keysPerThread = 5000;
+  std::vector<int> mismatches(threadCount, 0);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; ++t)
+    threads.emplace_back([&map, &mismatches, t, keysPerThread]()
+    {
+      const std::int32_t first = t * keysPerThread;
+      std::string value;
+      for (std::int32_t key = first; key < first + keysPerThread; ++key)
+        mismatches[t] += !map.insert_or_assign(key, std::to_string(key));
+      for (std::int32_t key = first; key < first + keysPerThread; key += 2)
+        mismatches[t] += !map.erase(key);
+      for (std::int32_t key = first; key < first + keysPerThread; ++key)
+        mismatches[t] += map.find(key, value) != (key % 2 == 1) || (key % 2 == 1 && value != std::to_string(key));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int t = 0; t < threadCount; ++t)
+    BOOST_CHECK_EQUAL(mismatches[t], 0);
+  BOOST_CHECK_EQUAL(map.getSize(), threadCount * keysPerThread / 2);
+}
+
+namespace
+{
+
+struct CountingHash : aisdi::IntegerHash
+{
+  static int calls;
+
+  std::size_t operator()(std::int32_t key) const
+  {
+    ++calls;
+    return aisdi::IntegerHash::operator()(key);
+  }
+};
+
+int CountingHash::calls = 0;
+
+template <typename TablePolicy>
+using CountingMap = aisdi::ConcurrentHashMap<std::int32_t, std::string, TablePolicy,
+                                             std::allocator<std::pair<const std::int32_t, std::string>>, CountingHash>;
+
+} // namespace
+
+using CountingMaps = boost::mpl::list<CountingMap<aisdi::ChainedBuckets>, CountingMap<aisdi::SwissTable>,
+                                      CountingMap<aisdi::RobinHood>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenUsingKeys_ThenEachOperationHashesItsKeyOnce, M, CountingMaps)
+{
+  M map(1);
+  for (std::int32_t i = 0; i < 100; ++i)  // past the inline slots, and a new key still does not make it grow
+    map.insert_or_assign(i, std::to_string(i));
+  std::string value;
+
+  CountingHash::calls = 0;
+  BOOST_CHECK(map.find(1, value));
+  BOOST_CHECK_EQUAL(map.valueOf(2), "2");
+  BOOST_CHECK(map.try_emplace(100, "100"));
+  BOOST_CHECK(!map.insert_or_assign(3, "three"));
+  BOOST_CHECK_EQUAL(map.compute(4, [](std::string& v) { return v.size(); }), 1);
+  BOOST_CHECK(map.erase(5));
+
+  BOOST_CHECK_EQUAL(CountingHash::calls, 6);
+  BOOST_CHECK_EQUAL(map.valueOf(3), "three");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+#include <ConcurrentTreeMap.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+// Boost.Test assertions are not thread safe, threads only record what they saw and the test checks it afterwards.
+using Map = aisdi::ConcurrentTreeMap<std::int32_t, std::string>;
+
+namespace
+{
+
+std::string valueFor(std::int32_t key) // long enough to live on the heap, so reading a freed one shows
+{
+  return "value of key number " + std::to_string(key);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ConcurrentTreeMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenUsedFromOneThread_ThenItBehavesAsTreeMap)
+{
+  Map map;
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+
+  BOOST_CHECK(map.insert_or_assign(2, "two"));
+  BOOST_CHECK(!map.insert_or_assign(2, "dwa"));
+  BOOST_CHECK(map.try_emplace(1, 3, 'a'));
+  BOOST_CHECK(!map.try_emplace(1, "ignored"));
+  BOOST_CHECK(map.try_emplace(3, "three"));
+
+  std::string value;
+  BOOST_CHECK(map.find(2, value));
+  BOOST_CHECK_EQUAL(value, "dwa");
+  BOOST_CHECK_EQUAL(map.valueOf(1), "aaa");
+  BOOST_CHECK(!map.find(4, value));
+  BOOST_CHECK(map.find(4) == map.end());
+  BOOST_CHECK_EQUAL(map.find(3)->second, "three");
+  BOOST_CHECK_THROW(map.valueOf(4), std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+  BOOST_CHECK_THROW(++map.end(), std::out_of_range);
+
+  BOOST_CHECK(map.remove(2));
+  BOOST_CHECK(!map.remove(2));
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_EQUAL(map.lowerBound(2)->first, 3);
+  BOOST_CHECK(map.lowerBound(4) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenItemsInRandomOrder_WhenIterating_ThenTheyComeInAscendingOrder)
+{
+  std::vector<std::int32_t> keys;
+  for (std::int32_t key = 0; key < 5000; ++key)
+    keys.push_back(key);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+
+  Map map;
+  std::map<std::int32_t, std::string> expected;
+  for (std::int32_t key : keys)
+  {
+    map.insert_or_assign(key, valueFor(key));
+    expected[key] = valueFor(key);
+  }
+  for (std::int32_t key = 0; key < 5000; key += 3)
+  {
+    map.remove(key);
+    expected.erase(key);
+  }
+
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+  BOOST_CHECK(std::equal(map.begin(), map.end(), expected.begin()));
+  BOOST_CHECK(std::equal(map.lowerBound(2500), map.end(), expected.lower_bound(2500)));
+  BOOST_CHECK_EQUAL(map.memoryUsage().payload, expected.size() * sizeof(Map::value_type));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenInsertingInterleavedKeys_ThenAllAreInOrder)
+{
+  Map map;
+  const int threadCount = 8;
+  const std::int32_t keysPerThread = 2000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; ++t)
+    threads.emplace_back([&map, t, keysPerThread]()
+    {
+      for (std::int32_t i = 0; i < keysPerThread; ++i)
+        map.try_emplace(i * threadCount + t, valueFor(i * threadCount + t));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(map.getSize(), threadCount * keysPerThread);
+  std::int32_t expectedKey = 0;
+  for (const auto& item : map)
+  {
+    BOOST_CHECK_EQUAL(item.first, expectedKey);
+    BOOST_CHECK_EQUAL(item.second, valueFor(expectedKey));
+    ++expectedKey;
+  }
+  BOOST_CHECK_EQUAL(expectedKey, threadCount * keysPerThread);
+}
+
+BOOST_AUTO_TEST_CASE(GivenScansRunning_WhenWritersRemoveAndInsert_ThenScansSeeEveryStableKeyInOrder)
+{
+  Map map;
+  const std::int32_t keyCount = 2000;    // even keys stay, odd ones are removed and inserted again
+  const int readerCount = 3;
+  const int writerCount = 2;
+  const int rounds = 20;
+  for (std::int32_t key = 0; key < keyCount; ++key)
+    map.insert_or_assign(key, valueFor(key));
+
+  std::atomic<int> writersLeft(writerCount);
+  std::vector<int> mismatches(readerCount, 0);
+  std::vector<int> scans(readerCount, 0);
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readerCount; ++r)
+    threads.emplace_back([&map, &writersLeft, &mismatches, &scans, r, keyCount]()
+    {
+      std::string value;
+      while (writersLeft.load() != 0 || scans[r] < 5)
+      {
+        std::int32_t from = (scans[r] * 337) % keyCount;
+        std::int32_t nextStable = from + from % 2;
+        std::int32_t previous = -1;
+        for (auto it = map.lowerBound(from); it != map.end(); ++it)
+        {
+          mismatches[r] += it->first <= previous || it->second != valueFor(it->first);
+          if (it->first % 2 == 0)
+          {
+            mismatches[r] += it->first != nextStable;
+            nextStable += 2;
+          }
+          previous = it->first;
+        }
+        mismatches[r] += nextStable != keyCount;
+        mismatches[r] += !map.find(from - from % 2, value) || value != valueFor(from - from % 2);
+        ++scans[r];
+      }
+    });
+  for (int w = 0; w < writerCount; ++w)
+    threads.emplace_back([&map, &writersLeft, w, keyCount, rounds]()
+    {
+      for (int round = 0; round < rounds; ++round)
+        for (std::int32_t key = 1 + 2 * w; key < keyCount; key += 2 * writerCount)
+        {
+          map.remove(key);
+          map.insert_or_assign(key, valueFor(key));
+          map.insert_or_assign(key - 1, valueFor(key - 1));
+        }
+      --writersLeft;
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int r = 0; r < readerCount; ++r)
+    BOOST_CHECK_EQUAL(mismatches[r], 0);
+  BOOST_CHECK_EQUAL(map.getSize(), keyCount);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
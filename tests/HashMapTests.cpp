@@ -198,6 +198,21 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenDereferencing_ThenOperationTh
   BOOST_CHECK_THROW(map.cend()->second, std::out_of_range);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenDereferencingEnd_ThenOperationThrows,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> small = { { 753, "Rome" } };
+  Map<K> large;
+  for (K i = 0; i < 100; ++i)
+    large[i] = "";
+
+  BOOST_CHECK_THROW(*small.end(), std::out_of_range);
+  BOOST_CHECK_THROW(*large.end(), std::out_of_range);
+  BOOST_CHECK_THROW(large.cend()->second, std::out_of_range);
+  BOOST_CHECK_EQUAL((*--large.end()).second, "");
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenConstIterator_WhenDereferencing_ThenItemIsReturned,
                               K,
                               TestedKeyTypes)
@@ -592,6 +607,224 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
 }
 
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenCreated_ThenLoadFactorIsZero,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK_EQUAL(map.load_factor(), 0.0f);
+  BOOST_CHECK(map.bucket_count() < 128);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingManyItems_ThenLoadFactorStaysBelowMaximum,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+
+  for (K i = 0; i < 1000; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+    BOOST_REQUIRE(map.load_factor() <= map.max_load_factor());
+  }
+
+  BOOST_CHECK_EQUAL(map.getSize(), 1000);
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenReserving_ThenNoRehashIsNeededUntilReservedSize,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  map.reserve(500);
+  const auto buckets = map.bucket_count();
+  for (K i = 0; i < 500; ++i)
+    map[i] = "";
+
+  BOOST_CHECK(buckets * map.max_load_factor() >= 500);
+  BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenRehashing_ThenAllItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 753, "Rome" }, { 1789, "Paris" }, { 1410, "Grunwald" } };
+
+  map.rehash(1024);
+  BOOST_CHECK(map.bucket_count() >= 1024);
+  thenMapContainsItems(map, { { 753, "Rome" }, { 1789, "Paris" }, { 1410, "Grunwald" } });
+
+  map.rehash(1);
+  BOOST_CHECK(map.bucket_count() >= 3);
+  thenMapContainsItems(map, { { 753, "Rome" }, { 1789, "Paris" }, { 1410, "Grunwald" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenLoweringMaxLoadFactor_ThenMapIsRehashed,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 100; ++i)
+    map[i] = "";
+
+  map.max_load_factor(0.25f);
+
+  BOOST_CHECK(map.load_factor() <= 0.25f);
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  BOOST_CHECK_THROW(map.max_load_factor(0.0f), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMovedFromMap_WhenAddingItem_ThenItemIsInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 753, "Rome" } };
+  Map<K> other{std::move(map)};
+
+  map[42] = "Alice";
+
+  thenMapContainsItems(map, { { 42, "Alice" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManyItems_WhenIteratingBothWays_ThenEachItemIsVisitedOnce,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 300; ++i)
+    map[i * 7] = std::to_string(i);
+
+  std::map<K, std::string> forward;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    forward[it->first] = it->second;
+
+  std::map<K, std::string> backward;
+  auto it = map.end();
+  while (it != map.begin())
+  {
+    --it;
+    backward[it->first] = it->second;
+  }
+
+  BOOST_CHECK_EQUAL(forward.size(), 300);
+  BOOST_CHECK(forward == backward);
+  thenMapContainsItems(map, forward);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManyItems_WhenRemovingFoundItems_ThenOthersAreStillFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 300; ++i)
+  {
+    map[i] = std::to_string(i);
+    if (i % 3 != 0)
+      expected[i] = std::to_string(i);
+  }
+
+  for (K i = 0; i < 300; i += 3)
+    map.remove(map.find(i));
+
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+  BOOST_CHECK(map.find(3) == map.end());
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithFewItems_WhenGettingMemoryUsage_ThenNothingIsAllocated,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 753, "Rome" }, { 1789, "Paris" } };
+
+  BOOST_CHECK_EQUAL(Map<K>().memoryUsage().allocated, sizeof(Map<K>));
+  BOOST_CHECK_EQUAL(map.memoryUsage().allocated, sizeof(Map<K>));
+  BOOST_CHECK_EQUAL(map.bucket_count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithReservedBuckets_WhenGettingMemoryUsage_ThenEmptyBucketsCostAPointer,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.reserve(1000);
+  const auto buckets = map.bucket_count();
+  const std::size_t bitmap = (buckets + 63) / 64 * sizeof(std::uint64_t);
+
+  BOOST_CHECK(buckets >= 1000);
+  BOOST_CHECK_EQUAL(map.memoryUsage().allocated, sizeof(Map<K>) + buckets * sizeof(void*) + bitmap);
+  map[7] = "seven";
+  BOOST_CHECK(map.memoryUsage().allocated > sizeof(Map<K>) + buckets * sizeof(void*) + bitmap);
+  map.remove(7);
+  BOOST_CHECK_EQUAL(map.memoryUsage().allocated, sizeof(Map<K>) + buckets * sizeof(void*) + bitmap);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithFewItems_WhenAddingAndRemovingItems_ThenItMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+
+  for (K i = 0; i < 12; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+    if (i % 2 == 1)
+    {
+      map.remove(i - 1);
+      expected.erase(i - 1);
+    }
+    BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+    thenMapContainsItems(map, expected);
+
+    std::size_t visited = 0;
+    for (auto it = map.end(); it != map.begin(); ++visited)
+      BOOST_CHECK(expected.count((--it)->first) == 1);
+    BOOST_CHECK_EQUAL(visited, expected.size());
+  }
+
+  BOOST_CHECK(map.bucket_count() > 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSparseMap_WhenIteratingBothWaysAndRemovingFirstItems_ThenEachItemIsVisitedOnce,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.reserve(100000);
+  std::map<K, std::string> expected;
+  for (K i = 1; i < 100; ++i)
+  {
+    map[i * 997] = std::to_string(i);
+    expected[i * 997] = std::to_string(i);
+  }
+
+  while (!map.isEmpty())
+  {
+    std::map<K, std::string> visited;
+    for (const auto& item : map)
+      visited.insert(item);
+    BOOST_REQUIRE(visited == expected);
+
+    std::size_t visitedBackwards = 0;
+    for (auto it = map.end(); it != map.begin(); ++visitedBackwards)
+      BOOST_CHECK(expected.count((--it)->first) == 1);
+    BOOST_CHECK_EQUAL(visitedBackwards, expected.size());
+
+    expected.erase(map.begin()->first);
+    map.remove(map.begin());
+  }
+  BOOST_CHECK(map.begin() == map.end());
+}
+
 
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
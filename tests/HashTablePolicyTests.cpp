@@ -0,0 +1,659 @@
+#include <HashMap.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+// Every HashMap table policy has to behave the same, these tests are run against each of them.
+using TestedMaps = boost::mpl::list<aisdi::HashMap<std::int32_t, std::string>,
+                                    aisdi::HashMap<std::int32_t, std::string, aisdi::SwissTable>,
+                                    aisdi::HashMap<std::uint64_t, std::string, aisdi::SwissTable>,
+                                    aisdi::HashMap<std::int32_t, std::string, aisdi::RobinHood>,
+                                    aisdi::HashMap<std::uint64_t, std::string, aisdi::RobinHood>,
+                                    aisdi::HashMap<std::int32_t, std::string, aisdi::ChainedBucketsWithHashes>,
+                                    aisdi::HashMap<std::int32_t, std::string, aisdi::ChainedBuckets,
+                                                   std::allocator<std::pair<const std::int32_t, std::string>>>>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(HashTablePolicyTests)
+
+template <typename M>
+void thenMapContainsItems(const M& map,
+                          const std::map<typename M::key_type, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    const auto it = map.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+  }
+
+  std::size_t visited = 0;
+  for (const auto& item : map)
+  {
+    BOOST_CHECK(expected.count(item.first) == 1);
+    ++visited;
+  }
+  BOOST_CHECK_EQUAL(visited, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingAndRemovingRandomKeys_ThenItMatchesStdMap,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> keys(0, 2000);
+  M map;
+  std::map<K, std::string> expected;
+
+  for (int i = 0; i < 20000; ++i)
+  {
+    const K key = keys(generator);
+    if (generator() % 3 == 0)
+    {
+      BOOST_CHECK_EQUAL(map.find(key) != map.end(), expected.count(key) == 1);
+      if (expected.erase(key) == 1)
+        map.remove(key);
+      else
+        BOOST_CHECK_THROW(map.remove(key), std::out_of_range);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+    BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManyItems_WhenIteratingBackwards_ThenEachItemIsVisitedOnce,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  for (K i = 0; i < 500; ++i)
+    map[i << 12] = std::to_string(i);
+
+  std::map<K, std::string> visited;
+  auto it = map.end();
+  while (it != map.begin())
+  {
+    --it;
+    visited[it->first] = it->second;
+  }
+
+  BOOST_CHECK_EQUAL(visited.size(), 500);
+  thenMapContainsItems(map, visited);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSparseMapAfterRemovals_WhenDecrementingFromEnd_ThenBeginStops,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  for (K i = 0; i < 1000; ++i)
+    map[i] = std::to_string(i);
+  for (K i = 0; i < 1000; ++i)
+    if (i % 100 != 99)
+      map.remove(i);
+
+  std::map<K, std::string> visited;
+  auto it = map.end();
+  for (int i = 0; i < 10; ++i)
+  {
+    --it;
+    visited[it->first] = it->second;
+  }
+  BOOST_CHECK(it == map.begin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+  BOOST_CHECK(it == map.begin());
+  BOOST_CHECK_EQUAL(visited.size(), 10);
+  thenMapContainsItems(map, visited);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenMovingIteratorsOutOfRange_ThenOperationThrows,
+                              M,
+                              TestedMaps)
+{
+  M map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(--map.begin(), std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapAfterRemovals_WhenCopyingAndMoving_ThenItemsAreKept,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 200; ++i)
+  {
+    map[i] = std::to_string(i);
+    if (i % 2 == 0)
+      map.remove(i);
+    else
+      expected[i] = std::to_string(i);
+  }
+
+  M copy{map};
+  M assigned;
+  assigned = map;
+  M moved{std::move(map)};
+
+  thenMapContainsItems(copy, expected);
+  thenMapContainsItems(assigned, expected);
+  thenMapContainsItems(moved, expected);
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(copy == moved);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenReserving_ThenAddingReservedItemsDoesNotRehash,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+
+  map.reserve(1000);
+  const auto buckets = map.bucket_count();
+  for (K i = 0; i < 1000; ++i)
+    map[i] = "";
+
+  BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+  BOOST_CHECK(map.load_factor() <= map.max_load_factor());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithRemovalChurn_WhenItNeverGrows_ThenLookupsStillTerminate,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  for (K i = 0; i < 10000; ++i)
+  {
+    map[i] = "";
+    if (i >= 8)
+      map.remove(i - 8);
+  }
+
+  BOOST_CHECK_EQUAL(map.getSize(), 8);
+  BOOST_CHECK(map.find(0) == map.end());
+  BOOST_CHECK(map.find(9999) != map.end());
+  BOOST_CHECK(map.bucket_count() < 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRobinHoodMapAtHighLoad_WhenChurningRemovals_ThenProbeLengthsStayShort)
+{
+  aisdi::HashMap<std::int32_t, std::string, aisdi::RobinHood> map;
+  map.max_load_factor(0.95f);
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<std::int32_t> keys;
+  std::vector<std::int32_t> inserted;
+
+  for (int i = 0; i < 50000; ++i)
+  {
+    inserted.push_back(keys(generator));
+    map[inserted.back()] = "";
+    if (inserted.size() > 7000)
+    {
+      std::swap(inserted[generator() % inserted.size()], inserted.back());
+      map.remove(inserted.back());
+      inserted.pop_back();
+    }
+  }
+
+  BOOST_CHECK(map.load_factor() > 0.8f);
+  BOOST_CHECK(map.meanProbeLength() >= 1.0);
+  BOOST_CHECK(map.meanProbeLength() < 6.0);
+  BOOST_CHECK(map.maxProbeLength() >= map.meanProbeLength());
+  BOOST_CHECK(map.maxProbeLength() < 64);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenGettingMemoryUsage_ThenPayloadIsElementsAndOverheadIsPositive,
+                              M,
+                              TestedMaps)
+{
+  M map;
+  const auto empty = map.memoryUsage();
+  for (int i = 0; i < 1000; ++i)
+    map[i] = "";
+
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(empty.payload, 0);
+  BOOST_CHECK(empty.allocated >= sizeof(M));
+  BOOST_CHECK_EQUAL(usage.payload, 1000 * sizeof(typename M::value_type));
+  BOOST_CHECK(usage.allocated > usage.payload + sizeof(M));
+  BOOST_CHECK(usage.overheadRatio() > 0.0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenReserving_ThenMemoryUsageGrowsButPayloadDoesNot,
+                              M,
+                              TestedMaps)
+{
+  M map;
+  const auto empty = map.memoryUsage();
+
+  map.reserve(1000);
+
+  BOOST_CHECK(map.memoryUsage().allocated > empty.allocated);
+  BOOST_CHECK_EQUAL(map.memoryUsage().payload, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyRobinHoodMap_WhenGettingProbeLengths_ThenTheyAreZero)
+{
+  const aisdi::HashMap<std::int32_t, std::string, aisdi::RobinHood> map;
+
+  BOOST_CHECK_EQUAL(map.maxProbeLength(), 0);
+  BOOST_CHECK_EQUAL(map.meanProbeLength(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenTryEmplacing_ThenOnlyMissingKeysGetValues,
+                              M,
+                              TestedMaps)
+{
+  M map;
+  for (int i = 0; i < 100; ++i)
+  {
+    const auto result = map.try_emplace(i, 3, 'a');
+    BOOST_CHECK(result.second);
+    BOOST_CHECK_EQUAL(result.first->second, "aaa");
+  }
+
+  std::string value = "moved";
+  for (int i = 0; i < 100; ++i)
+  {
+    const auto result = map.try_emplace(i, std::move(value));
+    BOOST_CHECK(!result.second);
+    BOOST_CHECK_EQUAL(result.first->first, i);
+  }
+
+  BOOST_CHECK_EQUAL(value, "moved");
+  std::map<typename M::key_type, std::string> expected;
+  for (int i = 0; i < 100; ++i)
+    expected[i] = "aaa";
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingOrAssigning_ThenExistingValuesAreReplaced,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 200; ++i)
+  {
+    const auto result = map.insert_or_assign(K(i % 120), std::to_string(i));
+    BOOST_CHECK_EQUAL(result.second, i < 120);
+    BOOST_CHECK_EQUAL(result.first->second, std::to_string(i));
+    expected[K(i % 120)] = std::to_string(i);
+  }
+
+  BOOST_CHECK(!map.emplace(K(7), "ignored").second);
+  BOOST_CHECK(map.emplace(std::make_pair(K(500), std::string("added"))).second);
+  expected[K(500)] = "added";
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingValueOfItsOwnElement_ThenValueSurvivesGrowth,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  const std::string value = "long enough not to fit in the string itself";
+  M map;
+  map[K(0)] = value;
+  for (int i = 1; i < 200; ++i)  // growing, leaving inline slots and shifting runs move the copied element
+  {
+    map.insert_or_assign(K(i), map.valueOf(K(i - 1)));
+    map.try_emplace(K(1000 + i), map.valueOf(K(i)));
+  }
+
+  BOOST_CHECK_EQUAL(map.getSize(), 399);
+  for (const auto& item : map)
+    BOOST_CHECK_EQUAL(item.second, value);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenEmplacedValueThrows_ThenMapIsUnchanged,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 1000; i += 2)
+  {
+    map[K(i)] = std::to_string(i);
+    expected[K(i)] = std::to_string(i);
+  }
+
+  for (int i = 1; i < 1000; i += 2)  // a string longer than max_size() cannot be made
+    BOOST_CHECK_THROW(map.try_emplace(K(i), std::string::npos, 'a'), std::length_error);
+
+  thenMapContainsItems(map, expected);
+  map[K(1)] = "1";
+  expected[K(1)] = "1";
+  thenMapContainsItems(map, expected);
+}
+
+using MoveOnlyValueMaps = boost::mpl::list<aisdi::HashMap<int, std::unique_ptr<int>>,
+                                           aisdi::HashMap<int, std::unique_ptr<int>, aisdi::SwissTable>,
+                                           aisdi::HashMap<int, std::unique_ptr<int>, aisdi::RobinHood>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapOfMoveOnlyValues_WhenEmplacing_ThenValuesAreMovedIn,
+                              M,
+                              MoveOnlyValueMaps)
+{
+  M map;
+  for (int i = 0; i < 100; ++i)
+  {
+    std::unique_ptr<int> value(new int(i));
+    const int* address = value.get();
+    map.try_emplace(i, std::move(value));
+    BOOST_CHECK(value == nullptr);
+    BOOST_CHECK_EQUAL(map.valueOf(i).get(), address);
+  }
+
+  map.insert_or_assign(5, std::unique_ptr<int>(new int(-5)));
+  map.emplace(100, std::unique_ptr<int>(new int(100)));
+  map[101].reset(new int(101));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 102);
+  for (int i = 0; i < 102; ++i)
+    BOOST_CHECK_EQUAL(*map.valueOf(i), i == 5 ? -5 : i);
+}
+
+using StringKeyedMaps = boost::mpl::list<aisdi::HashMap<std::string, int>,
+                                         aisdi::HashMap<std::string, int, aisdi::SwissTable>,
+                                         aisdi::HashMap<std::string, int, aisdi::RobinHood>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenStringKeyedMap_WhenLookingUpByStringViewsAndLiterals_ThenKeysAreFound,
+                              M,
+                              StringKeyedMaps)
+{
+  M map;
+  for (int i = 0; i < 300; ++i)
+    map["key" + std::to_string(i)] = i;
+
+  const std::string buffer = "GET key42 key299 key300 key";
+  const aisdi::StringView requested(buffer.data() + 4, 5);
+
+  BOOST_CHECK_EQUAL(map.find(requested)->second, 42);
+  BOOST_CHECK_EQUAL(map.valueOf(aisdi::StringView(buffer.data() + 10, 6)), 299);
+  BOOST_CHECK(map.find(aisdi::StringView(buffer.data() + 17, 6)) == map.end());
+  BOOST_CHECK(map.find(aisdi::StringView(buffer.data() + 24, 3)) == map.end());
+  BOOST_CHECK_EQUAL(map.find("key7")->second, 7);
+  BOOST_CHECK_THROW(map.valueOf("key"), std::out_of_range);
+
+  map.valueOf(requested) = -42;
+  map.remove("key0");
+  map.remove(requested);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 298);
+  BOOST_CHECK(map.find(std::string("key42")) == map.end());
+  BOOST_CHECK(map.find("key0") == map.end());
+  BOOST_CHECK_THROW(map.remove("key0"), std::out_of_range);
+}
+
+template <typename M, typename LookupKey, typename = void>
+struct CanFindBy : std::false_type
+{};
+
+template <typename M, typename LookupKey>
+struct CanFindBy<M, LookupKey, decltype(void(std::declval<const M&>().find(std::declval<const LookupKey&>())))>
+  : std::true_type
+{};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenStringKeyedMap_WhenLookingUpByOtherTypes_ThenOnlyTextIsAccepted,
+                              M,
+                              StringKeyedMaps)
+{
+  BOOST_CHECK((CanFindBy<M, std::string>::value));
+  BOOST_CHECK((CanFindBy<M, aisdi::StringView>::value));
+  BOOST_CHECK((CanFindBy<M, const char*>::value));
+  BOOST_CHECK((CanFindBy<M, char[4]>::value));
+  BOOST_CHECK((!CanFindBy<M, int>::value));
+  BOOST_CHECK((!CanFindBy<M, double>::value));
+  BOOST_CHECK((!CanFindBy<M, std::vector<char>>::value));
+}
+
+namespace
+{
+
+struct CopyLimited  // copying throws once the budget runs out
+{
+  static int copiesLeft;
+  static int alive;
+  int value;
+
+  explicit CopyLimited(int value = 0) : value(value)
+  {
+    ++alive;
+  }
+
+  CopyLimited(const CopyLimited& other) : value(other.value)
+  {
+    if (copiesLeft-- == 0)
+      throw std::runtime_error("copy budget exceeded");
+    ++alive;
+  }
+
+  CopyLimited& operator=(const CopyLimited&) = default;
+
+  ~CopyLimited()
+  {
+    --alive;
+  }
+};
+
+int CopyLimited::copiesLeft = -1;
+int CopyLimited::alive = 0;
+
+} // namespace
+
+using CopyLimitedMaps = boost::mpl::list<aisdi::HashMap<int, CopyLimited, aisdi::SwissTable>,
+                                         aisdi::HashMap<int, CopyLimited, aisdi::SwissTable,
+                                                        std::allocator<std::pair<const int, CopyLimited>>>,
+                                         aisdi::HashMap<int, CopyLimited, aisdi::RobinHood>,
+                                         aisdi::HashMap<int, CopyLimited, aisdi::ChainedBuckets>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopyingThrows_ThenNothingLeaksAndMapIsUnchanged,
+                              M,
+                              CopyLimitedMaps)
+{
+  M source;
+  for (int i = 0; i < 100; ++i)
+    source.emplace(i, CopyLimited(-i));
+  M map;
+  for (int i = 0; i < 10; ++i)
+    map.emplace(i, CopyLimited(i));
+
+  CopyLimited::copiesLeft = 50;
+  BOOST_CHECK_THROW(M copy(source), std::runtime_error);
+  CopyLimited::copiesLeft = 50;
+  BOOST_CHECK_THROW(map = source, std::runtime_error);
+  CopyLimited::copiesLeft = -1;
+
+  BOOST_CHECK_EQUAL(CopyLimited::alive, 110);
+  BOOST_REQUIRE_EQUAL(map.getSize(), 10);
+  for (int i = 0; i < 10; ++i)
+    BOOST_CHECK_EQUAL(map.valueOf(i).value, i);
+  map = source;
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  BOOST_CHECK_EQUAL(map.valueOf(99).value, -99);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenCopyingThrows_ThenNothingLeaksAndMapIsUnchanged,
+                              M,
+                              CopyLimitedMaps)
+{
+  M source;
+  for (int i = 0; i < 3; ++i)
+    source.emplace(i, CopyLimited(-i));
+  M map;
+  map.emplace(7, CopyLimited(7));
+
+  CopyLimited::copiesLeft = 2;
+  BOOST_CHECK_THROW(M copy(source), std::runtime_error);
+  CopyLimited::copiesLeft = 2;
+  BOOST_CHECK_THROW(map = source, std::runtime_error);
+  CopyLimited::copiesLeft = -1;
+
+  BOOST_CHECK_EQUAL(CopyLimited::alive, 4);
+  BOOST_REQUIRE_EQUAL(map.getSize(), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(7).value, 7);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopyingThrowsWhileGrowing_ThenNothingIsDestroyedTwiceAndMapIsUnchanged,
+                              M,
+                              CopyLimitedMaps)
+{
+  M map;
+  int failedGrowths = 0;
+  for (int i = 0; i < 200; ++i)
+  {
+    // growing copies every element, it only gets half of the copies it needs
+    if (map.getSize() + 1 > map.bucket_count() * map.max_load_factor())
+    {
+      CopyLimited::copiesLeft = static_cast<int>(map.getSize() / 2);
+      try
+      {
+        map.try_emplace(i, CopyLimited(i));
+      }
+      catch (const std::runtime_error&)
+      {
+        ++failedGrowths;
+      }
+      CopyLimited::copiesLeft = -1;
+
+      BOOST_CHECK_EQUAL(CopyLimited::alive, static_cast<int>(map.getSize()));
+      for (int j = 0; j < i; ++j)
+        BOOST_REQUIRE_EQUAL(map.valueOf(j).value, j);
+    }
+    map.try_emplace(i, CopyLimited(i));
+  }
+
+  BOOST_CHECK_GT(failedGrowths, 0);
+  BOOST_CHECK_EQUAL(map.getSize(), 200);
+  BOOST_CHECK_EQUAL(CopyLimited::alive, 200);
+}
+
+struct ConstantHash // every key collides, is_avalanching keeps the tables from mixing it
+{
+  using is_avalanching = void;
+
+  std::size_t operator()(std::int32_t) const
+  {
+    return 42;
+  }
+};
+
+using CollidingMaps = boost::mpl::list<aisdi::HashMap<std::int32_t, std::string, aisdi::ChainedBuckets,
+                                                      aisdi::PoolAllocator<std::pair<const std::int32_t, std::string>>,
+                                                      ConstantHash>,
+                                       aisdi::HashMap<std::int32_t, std::string, aisdi::ChainedBucketsWithHashes,
+                                                      aisdi::PoolAllocator<std::pair<const std::int32_t, std::string>>,
+                                                      ConstantHash>,
+                                       aisdi::HashMap<std::int32_t, std::string, aisdi::SwissTable,
+                                                      std::allocator<std::pair<const std::int32_t, std::string>>,
+                                                      ConstantHash>,
+                                       aisdi::HashMap<std::int32_t, std::string, aisdi::RobinHood,
+                                                      std::allocator<std::pair<const std::int32_t, std::string>>,
+                                                      ConstantHash>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingHasher_WhenAddingAndRemovingKeys_ThenItMatchesStdMap,
+                              M,
+                              CollidingMaps)
+{
+  M map;
+  std::map<std::int32_t, std::string> expected;
+  for (std::int32_t i = 0; i < 300; ++i)
+  {
+    map[i * 1024] = std::to_string(i);
+    expected[i * 1024] = std::to_string(i);
+  }
+  for (std::int32_t i = 0; i < 300; i += 3)
+  {
+    map.remove(i * 1024);
+    expected.erase(i * 1024);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.find(1) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapsWithAndWithoutCachedHashes_WhenGettingMemoryUsage_ThenCachingCostsAWordPerElement)
+{
+  aisdi::HashMap<std::int32_t, std::string> plain;
+  aisdi::HashMap<std::int32_t, std::string, aisdi::ChainedBucketsWithHashes> cached;
+  for (std::int32_t i = 0; i < 1000; ++i)
+  {
+    plain[i] = "";
+    cached[i] = "";
+  }
+
+  BOOST_CHECK_EQUAL(cached.memoryUsage().payload, plain.memoryUsage().payload);
+  BOOST_CHECK_GE(cached.memoryUsage().allocated, plain.memoryUsage().allocated + 1000 * sizeof(std::size_t));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStrideOfKeys_WhenHashingWithIntegerHash_ThenLowBitsAreSpread)
+{
+  const aisdi::IntegerHash hash;
+  std::vector<bool> used(1024, false);
+  std::size_t distinct = 0;
+  for (std::int32_t i = 0; i < 1024; ++i)
+  {
+    const std::size_t bucket = hash(i << 20) & 1023;
+    distinct += !used[bucket];
+    used[bucket] = true;
+  }
+
+  // 1024 random picks out of 1024 hit about 647 distinct buckets, the identity hash would hit one.
+  BOOST_CHECK_GT(distinct, 550);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTexts_WhenHashingWithStringHash_ThenEqualTextsHashEquallyAndPrefixesDiffer)
+{
+  const aisdi::Hash<std::string> hash;
+  std::string text;
+  std::vector<std::size_t> hashes;
+  for (int length = 0; length < 200; ++length)
+  {
+    BOOST_CHECK_EQUAL(hash(text), hash(text.c_str()));
+    BOOST_CHECK_EQUAL(hash(text), hash(aisdi::StringView(text.data(), text.size())));
+    hashes.push_back(hash(text));
+    text += static_cast<char>('a' + length % 26);
+  }
+
+  std::sort(hashes.begin(), hashes.end());
+  BOOST_CHECK(std::unique(hashes.begin(), hashes.end()) == hashes.end());
+  BOOST_CHECK_NE(hash("key1"), hash("key2"));
+  BOOST_CHECK_NE(hash(std::string("a\0b", 3)), hash(std::string("a\0c", 3)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
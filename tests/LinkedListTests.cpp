@@ -0,0 +1,131 @@
+#include <LinkedList.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+// The list is no longer used by any map, these tests keep it compiled and working on its own.
+using TestedLists = boost::mpl::list<aisdi::LinkedList<std::string>,
+                                     aisdi::LinkedList<std::string, std::allocator<std::string>>>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(LinkedListTests)
+
+template <typename L>
+void thenListContainsItemsInOrder(const L& list, const std::vector<std::string>& expected)
+{
+  BOOST_REQUIRE_EQUAL(list.getSize(), expected.size());
+  BOOST_CHECK_EQUAL(list.isEmpty(), expected.empty());
+
+  auto expectedIt = expected.begin();
+  for (const auto& item : list)
+    BOOST_CHECK_EQUAL(item, *expectedIt++);
+
+  auto it = list.end();
+  for (auto expectedRit = expected.rbegin(); expectedRit != expected.rend(); ++expectedRit)
+    BOOST_CHECK_EQUAL(*--it, *expectedRit);
+  BOOST_CHECK(it == list.begin());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyList_WhenAddingAndErasingItems_ThenTheyStayInOrder,
+                              L,
+                              TestedLists)
+{
+  L list;
+  thenListContainsItemsInOrder(list, {});
+  BOOST_CHECK_THROW(*list.begin(), std::out_of_range);
+  BOOST_CHECK_THROW(list.popFirst(), std::logic_error);
+
+  list.append("b");
+  list.prepend("a");
+  list.append("d");
+  list.insert(list.begin() + 2, "c");
+  thenListContainsItemsInOrder(list, { "a", "b", "c", "d" });
+
+  BOOST_CHECK_EQUAL(list.popFirst(), "a");
+  BOOST_CHECK_EQUAL(list.popLast(), "d");
+  list.erase(list.begin());
+  thenListContainsItemsInOrder(list, { "c" });
+  list.erase(list.begin());
+  thenListContainsItemsInOrder(list, {});
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenList_WhenCopyingAndMoving_ThenItemsAreKept,
+                              L,
+                              TestedLists)
+{
+  L list = { "one", "two", "three" };
+
+  L copy(list);
+  L assigned = { "old" };
+  assigned = list;
+  L moved(std::move(list));
+  L moveAssigned;
+  moveAssigned = std::move(moved);
+
+  thenListContainsItemsInOrder(copy, { "one", "two", "three" });
+  thenListContainsItemsInOrder(assigned, { "one", "two", "three" });
+  thenListContainsItemsInOrder(moveAssigned, { "one", "two", "three" });
+  copy.append("four");
+  BOOST_CHECK_EQUAL(assigned.getSize(), 3);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenListWithItems_WhenGettingMemoryUsage_ThenEveryItemAndTheSentinelAreCounted,
+                              L,
+                              TestedLists)
+{
+  L list;
+  const auto empty = list.memoryUsage();
+  for (int i = 0; i < 100; ++i)
+    list.append(std::to_string(i));
+
+  const auto usage = list.memoryUsage();
+  BOOST_CHECK_EQUAL(empty.payload, 0);
+  BOOST_CHECK(empty.allocated > sizeof(L));
+  BOOST_CHECK_EQUAL(usage.payload, 100 * sizeof(std::string));
+  BOOST_CHECK_EQUAL(usage.allocated - empty.allocated, 100 * (empty.allocated - sizeof(L)));
+
+  L moved(std::move(list));
+  BOOST_CHECK_EQUAL(list.memoryUsage().allocated, sizeof(L));
+  BOOST_CHECK_EQUAL(moved.memoryUsage().allocated, usage.allocated);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenList_WhenEmplacingAtBothEnds_ThenItemsAreConstructedInPlace,
+                              L,
+                              TestedLists)
+{
+  L list;
+  list.emplaceBack(3, 'b');
+  list.emplaceFront("a");
+  list.emplaceBack();
+  list.emplaceFront(2, 'z');
+
+  thenListContainsItemsInOrder(list, { "zz", "a", "bbb", "" });
+}
+
+BOOST_AUTO_TEST_CASE(GivenListOfMoveOnlyItems_WhenEmplacing_ThenItemsAreMovedIn)
+{
+  aisdi::LinkedList<std::unique_ptr<int>> list;
+  std::unique_ptr<int> item(new int(2));
+  const int* address = item.get();
+
+  list.emplaceBack(std::move(item));
+  list.emplaceFront(new int(1));
+  list.emplaceBack(new int(3));
+
+  BOOST_CHECK(item == nullptr);
+  BOOST_REQUIRE_EQUAL(list.getSize(), 3);
+  BOOST_CHECK_EQUAL(list[1].get(), address);
+  int expected = 1;
+  for (const auto& pointer : list)
+    BOOST_CHECK_EQUAL(*pointer, expected++);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,66 @@
+#include <NodePool.h>
+
+#include <cstdint>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(NodePoolTests)
+
+BOOST_AUTO_TEST_CASE(GivenPool_WhenAllocatingBlocks_ThenTheyAreDistinctAndAligned)
+{
+  aisdi::NodePool pool(24);
+  std::set<void*> blocks;
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    void* block = pool.allocate();
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t), 0);
+    BOOST_CHECK(blocks.insert(block).second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenPoolWithFreedBlock_WhenAllocating_ThenFreedBlockIsReused)
+{
+  aisdi::NodePool pool(24);
+  pool.allocate();
+  void* freed = pool.allocate();
+  pool.allocate();
+
+  pool.deallocate(freed);
+
+  BOOST_CHECK_EQUAL(pool.allocate(), freed);
+}
+
+BOOST_AUTO_TEST_CASE(GivenAllocator_WhenRebinding_ThenCopiesShareTheArena)
+{
+  aisdi::PoolAllocator<std::int32_t> allocator;
+  aisdi::PoolAllocator<double> rebound{allocator};
+  aisdi::PoolAllocator<std::int32_t> copy{allocator};
+
+  BOOST_CHECK(allocator == rebound);
+  BOOST_CHECK(allocator == copy);
+  BOOST_CHECK(allocator != aisdi::PoolAllocator<std::int32_t>());
+  BOOST_CHECK(allocator != allocator.select_on_container_copy_construction());
+
+  std::int32_t* value = copy.allocate(1);
+  allocator.deallocate(value, 1);
+  BOOST_CHECK_EQUAL(allocator.allocate(1), value);
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnusedAllocator_WhenCopying_ThenCopiesShareTheArena)
+{
+  const aisdi::PoolAllocator<std::int32_t> allocator;
+  aisdi::PoolAllocator<std::int32_t> copy{allocator};
+  aisdi::PoolAllocator<double> rebound{allocator};
+  aisdi::PoolAllocator<std::int32_t> assigned;
+
+  assigned = rebound;
+
+  BOOST_CHECK(copy == allocator);
+  BOOST_CHECK(rebound == allocator);
+  BOOST_CHECK(assigned == copy);
+  BOOST_CHECK(aisdi::PoolAllocator<std::int32_t>() != aisdi::PoolAllocator<std::int32_t>());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+#include <ReadMostlyHashMap.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+// Boost.Test assertions are not thread safe, threads only record what they saw and the test checks it afterwards.
+using Map = aisdi::ReadMostlyHashMap<std::int32_t, std::string>;
+
+namespace
+{
+
+std::string valueFor(std::int32_t key) // long enough to live on the heap, so reading a freed one shows
+{
+  return "value of key number " + std::to_string(key);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ReadMostlyHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenUsedFromOneThread_ThenItBehavesAsHashMap)
+{
+  Map map;
+  BOOST_CHECK(map.isEmpty());
+
+  BOOST_CHECK(map.insert_or_assign(1, "one"));
+  BOOST_CHECK(!map.insert_or_assign(1, "uno"));
+  BOOST_CHECK(map.try_emplace(2, 3, 'b'));
+  BOOST_CHECK(!map.try_emplace(2, "ignored"));
+
+  std::string value;
+  BOOST_CHECK(map.find(1, value));
+  BOOST_CHECK_EQUAL(value, "uno");
+  BOOST_CHECK_EQUAL(map.valueOf(2), "bbb");
+  BOOST_CHECK(!map.find(3, value));
+  BOOST_CHECK_THROW(map.valueOf(3), std::out_of_range);
+
+  BOOST_CHECK(map.erase(1));
+  BOOST_CHECK(!map.erase(1));
+  BOOST_CHECK(!map.find(1, value));
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyItems_WhenTableGrows_ThenAllAreStillFound)
+{
+  Map map;
+  const std::size_t initialBuckets = map.bucket_count();
+  for (std::int32_t key = 0; key < 10000; ++key)
+    map.insert_or_assign(key, valueFor(key));
+  for (std::int32_t key = 0; key < 10000; key += 2)
+    map.erase(key);
+
+  BOOST_CHECK_GT(map.bucket_count(), initialBuckets);
+  BOOST_CHECK_EQUAL(map.getSize(), 5000);
+  std::string value;
+  for (std::int32_t key = 0; key < 10000; ++key)
+    if (key % 2 == 1)
+      BOOST_CHECK_EQUAL(map.valueOf(key), valueFor(key));
+    else
+      BOOST_CHECK(!map.find(key, value));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithItems_WhenVisitingEachAndLookingUpInside_ThenEveryItemIsVisitedOnce)
+{
+  Map map;
+  std::map<std::int32_t, std::string> expected;
+  for (std::int32_t i = 0; i < 1000; ++i)
+  {
+    map.insert_or_assign(i, valueFor(i));
+    expected[i] = valueFor(i);
+  }
+
+  std::map<std::int32_t, std::string> visited;
+  map.for_each([&](const Map::value_type& item)
+  {
+    BOOST_CHECK(visited.insert(item).second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  });
+
+  BOOST_CHECK(visited == expected);
+  BOOST_CHECK_EQUAL(map.memoryUsage().payload, 1000 * sizeof(Map::value_type));
+}
+
+BOOST_AUTO_TEST_CASE(GivenReadersRunning_WhenWriterRemovesAndInserts_ThenReadersSeeOnlyWholeValues)
+{
+  Map map;
+  const std::int32_t stableKeys = 500;      // always present, reassigned with the same value
+  const std::int32_t churnedKeys = 500;     // removed and inserted again, round after round
+  const int readerCount = 4;
+  const int rounds = 50;
+  for (std::int32_t key = 0; key < stableKeys + churnedKeys; ++key)
+    map.insert_or_assign(key, valueFor(key));
+
+  std::atomic<bool> done(false);
+  std::vector<int> mismatches(readerCount, 0);
+  std::vector<long> reads(readerCount, 0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < readerCount; ++r)
+    readers.emplace_back([&map, &done, &mismatches, &reads, r, stableKeys, churnedKeys]()
+    {
+      std::string value;
+      for (std::int32_t key = r; !done.load() || reads[r] < 10000; key = (key + 7) % (stableKeys + churnedKeys))
+      {
+        bool found = map.find(key, value);
+        if (key < stableKeys)
+          mismatches[r] += !found || value != valueFor(key);
+        else
+          mismatches[r] += found && value != valueFor(key);
+        ++reads[r];
+      }
+      map.for_each([&](const Map::value_type& item) { mismatches[r] += item.second != valueFor(item.first); });
+    });
+
+  for (int round = 0; round < rounds; ++round)
+  {
+    for (std::int32_t key = stableKeys; key < stableKeys + churnedKeys; ++key)
+      map.erase(key);
+    for (std::int32_t key = 0; key < stableKeys + churnedKeys; ++key)
+      map.insert_or_assign(key, valueFor(key));
+  }
+  done.store(true);
+  for (auto& reader : readers)
+    reader.join();
+
+  for (int r = 0; r < readerCount; ++r)
+    BOOST_CHECK_EQUAL(mismatches[r], 0);
+  BOOST_CHECK_EQUAL(map.getSize(), stableKeys + churnedKeys);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
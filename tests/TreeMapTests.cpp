@@ -672,6 +672,81 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenGettingNextElement_ThenItemsA
   BOOST_CHECK(it == map.end());
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSortedKeys_WhenAddingThemAndDestroyingMap_ThenAllItemsAreInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 200000; ++i)
+    map[i] = "";
+
+  BOOST_CHECK_EQUAL(map.getSize(), 200000);
+  K expected = 0;
+  for (const auto& item : map)
+    BOOST_REQUIRE_EQUAL(item.first, expected++);
+  BOOST_CHECK_EQUAL(expected, 200000);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManySortedKeys_WhenCopying_ThenCopyIsEqualAndIndependent,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 200000; ++i)
+    map[i] = std::to_string(i % 10);
+
+  Map<K> copy{map};
+  Map<K> assigned = { { 1, "1" } };
+  assigned = copy;
+
+  BOOST_CHECK(copy == map);
+  BOOST_CHECK(assigned == map);
+
+  copy.remove(5);
+  copy[200000] = "new";
+  assigned[7] = "changed";
+  BOOST_CHECK_EQUAL(map.getSize(), 200000);
+  BOOST_CHECK_EQUAL(map.valueOf(5), "5");
+  BOOST_CHECK_EQUAL(map.valueOf(7), "7");
+  BOOST_CHECK(map.find(200000) == map.end());
+  BOOST_CHECK_EQUAL((--copy.end())->first, 200000);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingAndRemovingKeysInManyOrders_ThenItMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 3000; ++i)
+  {
+    const K key = (i * 7919) % 3001;
+    map[key] = std::to_string(i);
+    expected[key] = std::to_string(i);
+  }
+
+  for (K i = 0; i < 3000; i += 3)
+  {
+    map.remove(i);
+    expected.erase(i);
+  }
+  for (K i = 2999; i > 1500; i -= 2)
+  {
+    if (expected.erase(i) == 1)
+      map.remove(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  auto expectedIt = expected.begin();
+  for (const auto& item : map)
+    BOOST_REQUIRE_EQUAL(item.first, (expectedIt++)->first);
+
+  auto it = map.end();
+  for (auto reverseIt = expected.rbegin(); reverseIt != expected.rend(); ++reverseIt)
+    BOOST_REQUIRE_EQUAL((--it)->first, reverseIt->first);
+  BOOST_CHECK(it == map.begin());
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
@@ -0,0 +1,743 @@
+#include <TreeMap.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+// Every TreeMap tree policy has to behave the same, these tests are run against each of them.
+// Small B+ tree fanouts make splits, borrowing and merges happen on every few operations.
+using TestedMaps = boost::mpl::list<aisdi::TreeMap<std::int32_t, std::string>,
+                                    aisdi::TreeMap<std::int32_t, std::string, aisdi::BPlus<4>>,
+                                    aisdi::TreeMap<std::int32_t, std::string, aisdi::BPlus<5>>,
+                                    aisdi::TreeMap<std::int32_t, std::string, aisdi::BPlus<>>,
+                                    aisdi::TreeMap<std::uint64_t, std::string, aisdi::BPlus<>>,
+                                    aisdi::TreeMap<std::int32_t, std::string, aisdi::RedBlack,
+                                                   std::allocator<std::pair<const std::int32_t, std::string>>>,
+                                    aisdi::TreeMap<std::int32_t, std::string, aisdi::BPlus<4>,
+                                                   std::allocator<std::pair<const std::int32_t, std::string>>>>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(TreePolicyTests)
+
+template <typename M>
+void thenMapContainsItemsInOrder(const M& map,
+                                 const std::map<typename M::key_type, std::string>& expected)
+{
+  BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+
+  auto expectedIt = expected.begin();
+  for (const auto& item : map)
+  {
+    BOOST_REQUIRE(expectedIt != expected.end());
+    BOOST_CHECK_EQUAL(item.first, expectedIt->first);
+    BOOST_CHECK_EQUAL(item.second, expectedIt->second);
+    ++expectedIt;
+  }
+  BOOST_CHECK(expectedIt == expected.end());
+
+  auto it = map.end();
+  for (auto expectedRit = expected.rbegin(); expectedRit != expected.rend(); ++expectedRit)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, expectedRit->first);
+  }
+  BOOST_CHECK(it == map.begin());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAddingAndRemovingRandomKeys_ThenItMatchesStdMap,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> keys(0, 2000);
+  M map;
+  std::map<K, std::string> expected;
+
+  for (int i = 0; i < 30000; ++i)
+  {
+    const K key = keys(generator);
+    if (generator() % 2 == 0)
+    {
+      BOOST_CHECK_EQUAL(map.find(key) != map.end(), expected.count(key) == 1);
+      if (expected.erase(key) == 1)
+        map.remove(key);
+      else
+        BOOST_CHECK_THROW(map.remove(key), std::out_of_range);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+    BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+  }
+
+  thenMapContainsItemsInOrder(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManyItems_WhenRemovingAllOfThem_ThenMapIsEmpty,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  for (K i = 0; i < 3000; ++i)
+    map[i] = std::to_string(i);
+
+  for (K i = 0; i < 3000; i += 2)
+    map.remove(i);
+  for (K i = 1; i < 3000; i += 2)
+    map.remove(map.find(i));
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK_THROW(--map.end(), std::out_of_range);
+
+  map[7] = "7";
+  thenMapContainsItemsInOrder(map, { { 7, "7" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenMovingIteratorsOutOfRange_ThenOperationThrows,
+                              M,
+                              TestedMaps)
+{
+  M map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK_THROW(map.end()++, std::out_of_range);
+  BOOST_CHECK_THROW(--map.begin(), std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+  BOOST_CHECK_EQUAL((--map.end())->second, "Alice");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManyItems_WhenDecrementingFromEnd_ThenEveryItemIsVisitedAndBeginStops,
+                              M,
+                              TestedMaps)
+{
+  M map;
+  for (int i = 0; i < 1000; ++i)
+    map[(i * 7919) % 1000] = std::to_string(i);
+
+  auto it = map.end();
+  for (int key = 999; key >= 0; --key)
+    BOOST_REQUIRE_EQUAL((--it)->first, key);
+  BOOST_CHECK(it == map.begin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+  BOOST_CHECK(it == map.begin());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapAfterRemovals_WhenCopyingAndMoving_ThenItemsAreKept,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 500; ++i)
+  {
+    map[i] = std::to_string(i);
+    if (i % 3 == 0)
+      map.remove(i);
+    else
+      expected[i] = std::to_string(i);
+  }
+
+  M copy{map};
+  M assigned = { { 1000, "" } };
+  assigned = map;
+  M moved{std::move(map)};
+  M moveAssigned;
+  moveAssigned = std::move(moved);
+
+  thenMapContainsItemsInOrder(copy, expected);
+  thenMapContainsItemsInOrder(assigned, expected);
+  thenMapContainsItemsInOrder(moveAssigned, expected);
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(copy == moveAssigned);
+
+  copy[1] = "changed";
+  BOOST_CHECK_EQUAL(assigned.valueOf(1), "1");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingKeysInReverseOrder_ThenIterationIsSorted,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  std::map<K, std::string> expected;
+  for (K i = 20000; i > 0; --i)
+  {
+    map[i] = "";
+    expected[i] = "";
+  }
+
+  thenMapContainsItemsInOrder(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSortedRanges_WhenBuildingMaps_ThenTheyMatchStdMapAndStayUsable,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  for (std::size_t count : { 0, 1, 2, 3, 7, 8, 63, 64, 65, 1000, 4097 })
+  {
+    std::map<K, std::string> expected;
+    for (std::size_t i = 0; i < count; ++i)
+      expected[static_cast<K>(3 * i)] = std::to_string(i);
+
+    M map{aisdi::sortedInput, expected.begin(), expected.end()};
+    thenMapContainsItemsInOrder(map, expected);
+
+    std::mt19937 generator(static_cast<unsigned>(count));
+    for (std::size_t i = 0; i < 2 * count; ++i)
+    {
+      const K key = static_cast<K>(generator() % (3 * count + 3));
+      if (generator() % 2 == 0)
+      {
+        map[key] = "added";
+        expected[key] = "added";
+      }
+      else if (expected.erase(key) == 1)
+        map.remove(key);
+    }
+    thenMapContainsItemsInOrder(map, expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenAssigningSortedRange_ThenOldItemsAreReplaced,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map = { { 1, "1" }, { 100, "100" } };
+  const std::vector<std::pair<K, std::string>> sorted = { { 2, "two" }, { 5, "five" }, { 9, "nine" } };
+
+  map.assignSorted(sorted.begin(), sorted.end());
+
+  thenMapContainsItemsInOrder(map, { { 2, "two" }, { 5, "five" }, { 9, "nine" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenGettingMemoryUsage_ThenPayloadIsElementsAndOverheadIsPositive,
+                              M,
+                              TestedMaps)
+{
+  M map;
+  const auto empty = map.memoryUsage();
+  for (int i = 0; i < 1000; ++i)
+    map[i] = "";
+
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(empty.payload, 0);
+  BOOST_CHECK(empty.allocated >= sizeof(M));
+  BOOST_CHECK_EQUAL(usage.payload, 1000 * sizeof(typename M::value_type));
+  BOOST_CHECK(usage.allocated > usage.payload + sizeof(M));
+  BOOST_CHECK(usage.overheadRatio() > 0.0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItems_WhenRemovingAll_ThenMemoryUsageIsAsForEmptyMap,
+                              M,
+                              TestedMaps)
+{
+  M map;
+  const auto empty = map.memoryUsage();
+  for (int i = 0; i < 1000; ++i)
+    map[i] = "";
+
+  for (int i = 0; i < 1000; ++i)
+    map.remove(i);
+
+  BOOST_CHECK_EQUAL(map.memoryUsage().allocated, empty.allocated);
+  BOOST_CHECK_EQUAL(map.memoryUsage().payload, 0);
+}
+
+#ifndef NDEBUG
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenUnsortedRange_WhenAssigningIt_ThenExceptionIsThrownInDebugBuilds,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  const std::vector<std::pair<K, std::string>> unsorted = { { 2, "" }, { 9, "" }, { 5, "" } };
+  const std::vector<std::pair<K, std::string>> duplicated = { { 2, "" }, { 2, "" } };
+
+  BOOST_CHECK_THROW(map.assignSorted(unsorted.begin(), unsorted.end()), std::invalid_argument);
+  BOOST_CHECK_THROW(map.assignSorted(duplicated.begin(), duplicated.end()), std::invalid_argument);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenTryEmplacing_ThenOnlyMissingKeysGetValues,
+                              M,
+                              TestedMaps)
+{
+  M map;
+  for (int i = 0; i < 100; ++i)
+  {
+    const auto result = map.try_emplace(i, 3, 'a');
+    BOOST_CHECK(result.second);
+    BOOST_CHECK_EQUAL(result.first->second, "aaa");
+  }
+
+  std::string value = "moved";
+  for (int i = 0; i < 100; ++i)
+  {
+    const auto result = map.try_emplace(i, std::move(value));
+    BOOST_CHECK(!result.second);
+    BOOST_CHECK_EQUAL(result.first->first, i);
+  }
+
+  BOOST_CHECK_EQUAL(value, "moved");
+  std::map<typename M::key_type, std::string> expected;
+  for (int i = 0; i < 100; ++i)
+    expected[i] = "aaa";
+  thenMapContainsItemsInOrder(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingOrAssigning_ThenExistingValuesAreReplaced,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 200; ++i)
+  {
+    const auto result = map.insert_or_assign(K(i % 120), std::to_string(i));
+    BOOST_CHECK_EQUAL(result.second, i < 120);
+    BOOST_CHECK_EQUAL(result.first->second, std::to_string(i));
+    expected[K(i % 120)] = std::to_string(i);
+  }
+
+  BOOST_CHECK(!map.emplace(K(7), "ignored").second);
+  BOOST_CHECK(map.emplace(std::make_pair(K(500), std::string("added"))).second);
+  expected[K(500)] = "added";
+  thenMapContainsItemsInOrder(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenEmplacedValueThrows_ThenMapIsUnchanged,
+                              M,
+                              TestedMaps)
+{
+  using K = typename M::key_type;
+  M map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 1000; i += 2)
+  {
+    map[K(i)] = std::to_string(i);
+    expected[K(i)] = std::to_string(i);
+  }
+
+  for (int i = 1; i < 1000; i += 2)  // a string longer than max_size() cannot be made
+    BOOST_CHECK_THROW(map.try_emplace(K(i), std::string::npos, 'a'), std::length_error);
+
+  thenMapContainsItemsInOrder(map, expected);
+  map[K(1)] = "1";
+  expected[K(1)] = "1";
+  thenMapContainsItemsInOrder(map, expected);
+}
+
+using MoveOnlyValueMaps = boost::mpl::list<aisdi::TreeMap<int, std::unique_ptr<int>>,
+                                           aisdi::TreeMap<int, std::unique_ptr<int>, aisdi::BPlus<4>>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapOfMoveOnlyValues_WhenEmplacing_ThenValuesAreMovedIn,
+                              M,
+                              MoveOnlyValueMaps)
+{
+  M map;
+  for (int i = 0; i < 100; ++i)
+  {
+    std::unique_ptr<int> value(new int(i));
+    const int* address = value.get();
+    map.try_emplace(i, std::move(value));
+    BOOST_CHECK(value == nullptr);
+    BOOST_CHECK_EQUAL(map.valueOf(i).get(), address);
+  }
+
+  map.insert_or_assign(5, std::unique_ptr<int>(new int(-5)));
+  map.emplace(100, std::unique_ptr<int>(new int(100)));
+  map[101].reset(new int(101));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 102);
+  for (int i = 0; i < 102; ++i)
+    BOOST_CHECK_EQUAL(*map.valueOf(i), i == 5 ? -5 : i);
+}
+
+namespace
+{
+
+struct CopyLimited  // copying throws once the budget runs out
+{
+  static int copiesLeft;
+  int value;
+
+  explicit CopyLimited(int value = 0) : value(value)
+  {}
+
+  CopyLimited(const CopyLimited& other) : value(other.value)
+  {
+    if (copiesLeft-- == 0)
+      throw std::runtime_error("copy budget exceeded");
+  }
+
+  CopyLimited& operator=(const CopyLimited&) = default;
+};
+
+int CopyLimited::copiesLeft = -1;
+
+} // namespace
+
+using CopyLimitedMaps = boost::mpl::list<aisdi::TreeMap<int, CopyLimited>,
+                                         aisdi::TreeMap<int, CopyLimited, aisdi::BPlus<4>>,
+                                         aisdi::TreeMap<int, CopyLimited, aisdi::RedBlack,
+                                                        std::allocator<std::pair<const int, CopyLimited>>>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopyAssignmentThrows_ThenMapIsUnchanged,
+                              M,
+                              CopyLimitedMaps)
+{
+  M source;
+  for (int i = 0; i < 100; ++i)
+    source.emplace(i, CopyLimited(-i));
+  M map;
+  for (int i = 0; i < 10; ++i)
+    map.emplace(i, CopyLimited(i));
+
+  CopyLimited::copiesLeft = 50;
+  BOOST_CHECK_THROW(map = source, std::runtime_error);
+  CopyLimited::copiesLeft = -1;
+
+  BOOST_REQUIRE_EQUAL(map.getSize(), 10);
+  for (int i = 0; i < 10; ++i)
+    BOOST_CHECK_EQUAL(map.valueOf(i).value, i);
+  map = source;
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  BOOST_CHECK_EQUAL(map.valueOf(99).value, -99);
+}
+
+struct CopyLimitedKey  // copying or assigning a key throws once the budget runs out
+{
+  static int copiesLeft;
+  int value;
+
+  CopyLimitedKey(int value = 0) : value(value)
+  {}
+
+  CopyLimitedKey(const CopyLimitedKey& other) : value(other.value)
+  {
+    spend();
+  }
+
+  CopyLimitedKey& operator=(const CopyLimitedKey& other)
+  {
+    spend();
+    value = other.value;
+    return *this;
+  }
+
+  static void spend()
+  {
+    if (copiesLeft-- == 0)
+      throw std::runtime_error("copy budget exceeded");
+  }
+
+  bool operator<(const CopyLimitedKey& other) const
+  {
+    return value < other.value;
+  }
+
+  bool operator==(const CopyLimitedKey& other) const
+  {
+    return value == other.value;
+  }
+};
+
+int CopyLimitedKey::copiesLeft = -1;
+
+using CopyLimitedKeyMaps = boost::mpl::list<aisdi::TreeMap<CopyLimitedKey, int>,
+                                            aisdi::TreeMap<CopyLimitedKey, int, aisdi::BPlus<4>>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAssigningSortedRangeThrows_ThenMapIsUnchanged,
+                              M,
+                              CopyLimitedKeyMaps)
+{
+  std::vector<std::pair<CopyLimitedKey, int>> sorted;
+  for (int i = 0; i < 500; ++i)
+    sorted.emplace_back(i, i);
+  M map = { { 1000, -1 }, { 2000, -2 } };
+  const auto usage = map.memoryUsage();
+  const int copies = [&sorted]()
+  {
+    CopyLimitedKey::copiesLeft = 100000;
+    M().assignSorted(sorted.begin(), sorted.end());
+    return 100000 - CopyLimitedKey::copiesLeft;
+  }();
+
+  for (int budget : { 0, copies / 4, copies / 2, copies - 1 })  // B+ trees build inner levels last
+  {
+    CopyLimitedKey::copiesLeft = budget;
+    BOOST_CHECK_THROW(map.assignSorted(sorted.begin(), sorted.end()), std::runtime_error);
+    CopyLimitedKey::copiesLeft = -1;
+    BOOST_REQUIRE_EQUAL(map.getSize(), 2);
+    BOOST_CHECK_EQUAL(map.valueOf(1000), -1);
+    BOOST_CHECK_EQUAL(map.valueOf(2000), -2);
+    BOOST_CHECK_EQUAL(map.memoryUsage().allocated, usage.allocated);
+  }
+
+  map.assignSorted(sorted.begin(), sorted.end());
+  BOOST_CHECK_EQUAL(map.getSize(), 500);
+  BOOST_CHECK_EQUAL(map.valueOf(499), 499);
+  BOOST_CHECK(map.find(1000) == map.end());
+}
+
+struct CountedKey  // no default constructor, every key made is counted until it is destroyed
+{
+  static int alive;
+  int value;
+
+  explicit CountedKey(int value) : value(value)
+  {
+    ++alive;
+  }
+
+  CountedKey(const CountedKey& other) : value(other.value)
+  {
+    ++alive;
+  }
+
+  CountedKey& operator=(const CountedKey&) = default;
+
+  ~CountedKey()
+  {
+    --alive;
+  }
+
+  bool operator<(const CountedKey& other) const
+  {
+    return value < other.value;
+  }
+
+  bool operator==(const CountedKey& other) const
+  {
+    return value == other.value;
+  }
+};
+
+int CountedKey::alive = 0;
+
+// The red-black tree keeps a whole value in its sentinel, so only B+ trees take such keys.
+using CountedKeyMaps = boost::mpl::list<aisdi::TreeMap<CountedKey, int, aisdi::BPlus<4>>,
+                                        aisdi::TreeMap<CountedKey, int, aisdi::BPlus<>>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenKeysWithoutDefaultConstructor_WhenUsingMap_ThenEveryKeyMadeIsDestroyed,
+                              M,
+                              CountedKeyMaps)
+{
+  {
+    M map;
+    std::map<int, int> expected;
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> keys(0, 999);
+    for (int i = 0; i < 3000; ++i)
+    {
+      const int key = keys(generator);
+      if (expected.count(key) != 0)
+      {
+        map.remove(CountedKey(key));
+        expected.erase(key);
+      }
+      else
+      {
+        map.emplace(CountedKey(key), key);
+        expected[key] = key;
+      }
+    }
+
+    M copy(map);
+    std::vector<std::pair<CountedKey, int>> sorted;
+    for (int i = 0; i < 200; ++i)
+      sorted.emplace_back(CountedKey(i), -i);
+    map.assignSorted(sorted.begin(), sorted.end());
+
+    BOOST_REQUIRE_EQUAL(copy.getSize(), expected.size());
+    auto expectedIt = expected.begin();
+    for (const auto& item : copy)
+      BOOST_CHECK_EQUAL(item.first.value, (expectedIt++)->first);
+    BOOST_CHECK_EQUAL(map.getSize(), 200);
+    BOOST_CHECK_EQUAL(map.valueOf(CountedKey(199)), -199);
+  }
+  BOOST_CHECK_EQUAL(CountedKey::alive, 0);
+}
+
+struct AllocationLimit  // allocations fail once the budget runs out
+{
+  static int allocationsLeft;
+  static int live;
+};
+
+int AllocationLimit::allocationsLeft = -1;
+int AllocationLimit::live = 0;
+
+template <typename T>
+struct LimitedAllocator
+{
+  using value_type = T;
+
+  LimitedAllocator() = default;
+
+  template <typename Other>
+  LimitedAllocator(const LimitedAllocator<Other>&)
+  {}
+
+  T* allocate(std::size_t count)
+  {
+    if (AllocationLimit::allocationsLeft-- == 0)
+      throw std::bad_alloc();
+    ++AllocationLimit::live;
+    return static_cast<T*>(::operator new(count * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, std::size_t)
+  {
+    --AllocationLimit::live;
+    ::operator delete(pointer);
+  }
+
+  template <typename Other>
+  bool operator==(const LimitedAllocator<Other>&) const
+  {
+    return true;
+  }
+
+  template <typename Other>
+  bool operator!=(const LimitedAllocator<Other>&) const
+  {
+    return false;
+  }
+};
+
+using AllocationLimitedMaps =
+    boost::mpl::list<aisdi::TreeMap<std::int32_t, std::string, aisdi::RedBlack,
+                                    LimitedAllocator<std::pair<const std::int32_t, std::string>>>,
+                     aisdi::TreeMap<std::int32_t, std::string, aisdi::BPlus<4>,
+                                    LimitedAllocator<std::pair<const std::int32_t, std::string>>>,
+                     aisdi::TreeMap<std::int32_t, std::string, aisdi::BPlus<5>,
+                                    LimitedAllocator<std::pair<const std::int32_t, std::string>>>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenAllocationFailsWhileInserting_ThenMapIsUnchangedAndNothingLeaks,
+                              M,
+                              AllocationLimitedMaps)
+{
+  {
+    M map;
+    std::map<std::int32_t, std::string> expected;
+    for (int i = 0; i < 300; ++i)
+    {
+      const std::int32_t key = (i * 7919) % 300;
+      for (int budget : { 0, 1, 2 })  // fails on the new leaf, or on inner nodes a split reaches
+      {
+        AllocationLimit::allocationsLeft = budget;
+        try
+        {
+          map.emplace(key, std::to_string(key));
+          AllocationLimit::allocationsLeft = -1;
+          expected[key] = std::to_string(key);
+          break;
+        }
+        catch (const std::bad_alloc&)
+        {
+          AllocationLimit::allocationsLeft = -1;
+          thenMapContainsItemsInOrder(map, expected);
+        }
+      }
+      if (expected.count(key) == 0)
+      {
+        map.emplace(key, std::to_string(key));
+        expected[key] = std::to_string(key);
+      }
+    }
+    thenMapContainsItemsInOrder(map, expected);
+  }
+  BOOST_CHECK_EQUAL(AllocationLimit::live, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMaps_WhenCreatingCopyingAndMovingThem_ThenNothingIsAllocated,
+                              M,
+                              AllocationLimitedMaps)
+{
+  AllocationLimit::allocationsLeft = 0;
+  {
+    M map;
+    M copy(map);
+    M moved(std::move(map));
+    copy = moved;
+    moved = std::move(copy);
+    BOOST_CHECK(map.begin() == map.end());
+    BOOST_CHECK(moved.begin() == moved.end());
+  }
+  AllocationLimit::allocationsLeft = -1;
+  BOOST_CHECK_EQUAL(AllocationLimit::live, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMovedFromMap_WhenUsingIt_ThenItIsEmptyAndTakesItems,
+                              M,
+                              TestedMaps)
+{
+  M map = { { 1, "one" }, { 2, "two" } };
+  M moved(std::move(map));
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.find(1) == map.end());
+
+  map[3] = "three";
+  moved = std::move(map);
+  BOOST_CHECK(map.isEmpty());
+  map[4] = "four";
+  thenMapContainsItemsInOrder(moved, { { 3, "three" } });
+  thenMapContainsItemsInOrder(map, { { 4, "four" } });
+}
+
+using StringKeyedMaps = boost::mpl::list<aisdi::TreeMap<std::string, int>,
+                                         aisdi::TreeMap<std::string, int, aisdi::BPlus<4>>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenStringKeyedMap_WhenLookingUpByStringViewsAndLiterals_ThenKeysAreFound,
+                              M,
+                              StringKeyedMaps)
+{
+  M map;
+  for (int i = 0; i < 300; ++i)
+    map["key" + std::to_string(i)] = i;
+
+  const std::string buffer = "GET key42 key299 key300 key";
+  const aisdi::StringView requested(buffer.data() + 4, 5);
+
+  BOOST_CHECK_EQUAL(map.find(requested)->second, 42);
+  BOOST_CHECK_EQUAL(map.valueOf(aisdi::StringView(buffer.data() + 10, 6)), 299);
+  BOOST_CHECK(map.find(aisdi::StringView(buffer.data() + 17, 6)) == map.end());
+  BOOST_CHECK(map.find(aisdi::StringView(buffer.data() + 24, 3)) == map.end());
+  BOOST_CHECK_EQUAL(map.find("key7")->second, 7);
+  BOOST_CHECK_THROW(map.valueOf("key"), std::out_of_range);
+
+  map.valueOf(requested) = -42;
+  map.remove("key0");
+  map.remove(requested);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 298);
+  BOOST_CHECK(map.find(std::string("key42")) == map.end());
+  BOOST_CHECK(map.find("key0") == map.end());
+  BOOST_CHECK_THROW(map.remove("key0"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_SUITE_END()